@@ -0,0 +1,117 @@
+//
+//  Argsort.h
+//  Algorithms332
+//
+//  Indirect sorting: instead of moving the records, sort an array of their
+//  indices, so each exchange or merge step moves one 32- or 64-bit index
+//  instead of a whole record.  The result perm is the sorted order:
+//  arr[perm[0]] <= arr[perm[1]] <= ...  Callers can gather just the fields
+//  they need through perm, or reorder the records once with
+//  apply_permutation.
+//
+//    std::vector<uint32_t> perm = argsort<student>::merge(arr, n, by_name);
+//    apply_permutation(arr, perm.data(), n);
+//
+
+#ifndef Argsort_h
+#define Argsort_h
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Utils.h"
+#include "Merge_Sort.h"
+#include "Quick_Sort.h"
+#include "Heap_Sort.h"
+
+
+//------------------------------------------------------
+// Each engine runs the sort of the same name on the index array, with a
+// comparator that compares the records the indices point at:
+//   merge  stable (equal records keep their index order)
+//   quick  not stable; shuffles the indices first, like quick_sort
+//   heap   not stable; no scratch memory beyond perm
+// Index is uint32_t by default (n must then fit in 32 bits) or size_t.
+//------------------------------------------------------
+template <typename T>
+class argsort {
+public:
+	template <typename Index = uint32_t, typename Comp = fwd_comparator<T>>
+	static std::vector<Index> merge(const T* arr, size_t n, const Comp& comp = Comp())
+	{
+		std::vector<Index> perm = identity<Index>(n);
+		merge_sort<Index>::sort(perm.data(), n, by_record<Index>(arr, comp));
+		return perm;
+	}
+
+	template <typename Index = uint32_t, typename Comp = fwd_comparator<T>>
+	static std::vector<Index> quick(const T* arr, size_t n, const Comp& comp = Comp())
+	{
+		std::vector<Index> perm = identity<Index>(n);
+		quick_sort<Index>::sort(perm.data(), n, by_record<Index>(arr, comp));
+		return perm;
+	}
+
+	template <typename Index = uint32_t, typename Comp = fwd_comparator<T>>
+	static std::vector<Index> heap(const T* arr, size_t n, const Comp& comp = Comp())
+	{
+		std::vector<Index> perm = identity<Index>(n);
+		heap_sort<Index>::sort(perm.data(), n, by_record<Index>(arr, comp));
+		return perm;
+	}
+
+private:
+	template <typename Index, typename Comp>
+	struct record_comparator {
+		bool operator()(Index i, Index j) const { return less(arr[i], arr[j], comp); }
+		const T* arr;
+		const Comp& comp;
+	};
+
+	template <typename Index, typename Comp>
+	static record_comparator<Index, Comp> by_record(const T* arr, const Comp& comp)
+	{
+		return record_comparator<Index, Comp>{ arr, comp };
+	}
+
+	template <typename Index>
+	static std::vector<Index> identity(size_t n)
+	{
+		assert(n - 1 <= size_t(std::numeric_limits<Index>::max()) || n == 0);
+		std::vector<Index> perm(n);
+		for (size_t i = 0; i < n; ++i) { perm[i] = Index(i); }
+		return perm;
+	}
+};
+
+
+//------------------------------------------------------
+// Reorders arr in place so that arr[i] becomes the old arr[perm[i]], e.g.
+// with the perm an argsort returned.  Follows the permutation's cycles:
+// one move per element plus one per cycle, and n bits to remember which
+// elements are already placed; perm itself is left unchanged, so it can
+// reorder other arrays (struct-of-arrays fields) afterwards.
+//------------------------------------------------------
+template <typename T, typename Index>
+void apply_permutation(T* arr, const Index* perm, size_t n)
+{
+	std::vector<bool> placed(n);
+	for (size_t start = 0; start < n; ++start) {
+		if (placed[start]) { continue; }
+		placed[start] = true;
+		if (size_t(perm[start]) == start) { continue; }
+
+		T held = std::move(arr[start]);
+		size_t i = start;
+		for (size_t next = size_t(perm[i]); next != start; next = size_t(perm[i])) {
+			arr[i] = std::move(arr[next]);
+			placed[next] = true;
+			i = next;
+		}
+		arr[i] = std::move(held);
+	}
+}
+
+#endif /* Argsort_h */
@@ -0,0 +1,371 @@
+//
+//  External_Sort.h
+//  Algorithms332
+//
+//  Sorts inputs larger than memory.  The input is read in chunks that fit a
+//  memory budget; each chunk is sorted with one of the in-memory sorts and
+//  written to a temp file as a sorted run; the runs are then merged k at a
+//  time through a loser (tournament) tree into the output.  Every file is
+//  read and written sequentially through large buffers.
+//
+//    external_sort<text_records>::sort(std::cin, std::cout, 256 << 20);
+//    external_sort<binary_records<int>>::sort(in, out, 64 << 20, rev_comparator<int>());
+//
+
+#ifndef External_Sort_h
+#define External_Sort_h
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Utils.h"
+#include "Merge_Sort.h"
+#include "Quick_Sort.h"
+
+
+//------------------------------------------------------
+// A temp file holding one sorted run: written once front to back, then
+// rewound and read back front to back, both through a buffer of
+// buffer_size bytes.  Created with std::tmpfile() when dir is empty,
+// otherwise as a uniquely named file in dir that is removed on close.
+//------------------------------------------------------
+class run_file {
+public:
+	explicit run_file(const std::string& dir, size_t buffer_size = 1 << 20)
+		: file_(nullptr), buf_(buffer_size), pos_(0), end_(0), reading_(false) {
+		if (dir.empty()) { file_ = std::tmpfile(); }
+		else {
+			static std::atomic<unsigned long> counter(0);
+			path_ = dir + "/external_sort_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())
+				+ "_" + std::to_string(counter++) + ".run";
+			file_ = std::fopen(path_.c_str(), "w+b");
+		}
+		if (file_ == nullptr) { throw new std::runtime_error("external_sort: cannot create a temp file in '" + dir + "'"); }
+	}
+
+	~run_file() {
+		std::fclose(file_);
+		if (!path_.empty()) { std::remove(path_.c_str()); }
+	}
+
+	run_file(const run_file&) = delete;
+	run_file& operator=(const run_file&) = delete;
+
+	void write(const void* data, size_t n) {
+		assert(!reading_);
+		const char* p = (const char*)data;
+		while (n > 0) {
+			if (pos_ == buf_.size()) { flush(); }
+			size_t k = std::min(n, buf_.size() - pos_);
+			std::memcpy(buf_.data() + pos_, p, k);
+			pos_ += k;
+			p += k;
+			n -= k;
+		}
+	}
+
+	// done writing: flushes and frees the buffer until the run is read back
+	void finish() {
+		flush();
+		if (std::fflush(file_) != 0) { throw new std::runtime_error("external_sort: write to temp file failed"); }
+		std::vector<char>().swap(buf_);
+	}
+
+	// switches to reading from the start of the file through a buffer of buffer_size bytes
+	void rewind(size_t buffer_size) {
+		if (!buf_.empty()) { finish(); }
+		std::rewind(file_);
+		buf_.resize(buffer_size);
+		pos_ = end_ = 0;
+		reading_ = true;
+	}
+
+	bool read(void* data, size_t n) {
+		assert(reading_);
+		char* p = (char*)data;
+		while (n > 0) {
+			if (pos_ == end_ && !fill()) { return false; }
+			size_t k = std::min(n, end_ - pos_);
+			std::memcpy(p, buf_.data() + pos_, k);
+			pos_ += k;
+			p += k;
+			n -= k;
+		}
+		return true;
+	}
+
+	// reads up to the next '\n' (not stored)
+	bool read_line(std::string& s) {
+		assert(reading_);
+		s.clear();
+		while (true) {
+			if (pos_ == end_ && !fill()) { return !s.empty(); }
+			const char* start = buf_.data() + pos_;
+			const char* nl = (const char*)std::memchr(start, '\n', end_ - pos_);
+			if (nl != nullptr) {
+				s.append(start, nl);
+				pos_ += (nl - start) + 1;
+				return true;
+			}
+			s.append(start, end_ - pos_);
+			pos_ = end_;
+		}
+	}
+
+private:
+	void flush() {
+		if (pos_ > 0 && std::fwrite(buf_.data(), 1, pos_, file_) != pos_) {
+			throw new std::runtime_error("external_sort: write to temp file failed (disk full?)");
+		}
+		pos_ = 0;
+	}
+
+	bool fill() {
+		pos_ = 0;
+		end_ = std::fread(buf_.data(), 1, buf_.size(), file_);
+		return end_ > 0;
+	}
+
+	FILE* file_;
+	std::string path_;
+	std::vector<char> buf_;
+	size_t pos_, end_;
+	bool reading_;
+};
+
+
+//------------------------------------------------------
+// Record formats: how external_sort reads the input, writes the output,
+// stores records in run files, and how many bytes of memory a record
+// holds beyond sizeof(value_type).
+//------------------------------------------------------
+
+// whitespace-separated tokens (as std::cin >> s reads them), written one per line
+struct text_records {
+	typedef std::string value_type;
+
+	static bool read(std::istream& in, std::string& s) { return bool(in >> s); }
+	static void write(std::ostream& out, const std::string& s) { out << s << '\n'; }
+
+	static void spill(run_file& f, const std::string& s) {
+		f.write(s.data(), s.size());
+		f.write("\n", 1);
+	}
+	static bool load(run_file& f, std::string& s) { return f.read_line(s); }
+
+	// 0 for short strings stored inside the string object itself
+	static size_t heap_bytes(const std::string& s) {
+		const char* self = (const char*)&s;
+		return s.data() >= self && s.data() < self + sizeof(s) ? 0 : s.capacity() + 1;
+	}
+};
+
+// fixed-size records in native byte order, back to back
+template <typename T>
+struct binary_records {
+	static_assert(std::is_trivially_copyable<T>::value, "binary_records needs a trivially copyable type");
+	typedef T value_type;
+
+	static bool read(std::istream& in, T& v) { return bool(in.read((char*)&v, sizeof(T))); }
+	static void write(std::ostream& out, const T& v) { out.write((const char*)&v, sizeof(T)); }
+
+	static void spill(run_file& f, const T& v) { f.write(&v, sizeof(T)); }
+	static bool load(run_file& f, T& v) { return f.read(&v, sizeof(T)); }
+
+	static size_t heap_bytes(const T&) { return 0; }
+};
+
+
+//------------------------------------------------------
+// Loser tree over k sorted sources (Knuth 5.4.1): internal node i holds the
+// source that lost the match played there, node 0 the overall winner.
+// After the winner's source advances, replay() plays it back up its one
+// leaf-to-root path: lg k comparisons per record, against lg k * 2 for a
+// binary heap's sift-down.  Exhausted sources lose every match, and ties
+// go to the lower source index, so merging runs made in input order keeps
+// equal records in input order.
+//------------------------------------------------------
+template <typename T, typename Comp>
+class loser_tree {
+public:
+	loser_tree(const std::vector<T>& heads, const std::vector<bool>& live, const Comp& comp)
+		: heads_(heads), live_(live), comp_(comp), k_(heads.size()), tree_(heads.size() == 0 ? 1 : heads.size()) {
+		if (k_ > 0) { tree_[0] = build(1); }
+	}
+
+	size_t winner() const { return tree_[0]; }
+
+	// call after heads[s] or live[s] of the current winner s changed
+	void replay(size_t s) {
+		for (size_t node = (s + k_) / 2; node > 0; node /= 2) {
+			if (beats(tree_[node], s)) { std::swap(tree_[node], s); }
+		}
+		tree_[0] = s;
+	}
+
+private:
+	// nodes 1 .. k-1 are internal, k .. 2k-1 are the sources
+	size_t build(size_t node) {
+		if (node >= k_) { return node - k_; }
+		size_t a = build(2 * node), b = build(2 * node + 1);
+		if (beats(b, a)) { std::swap(a, b); }
+		tree_[node] = b;
+		return a;
+	}
+
+	bool beats(size_t a, size_t b) const {
+		if (live_[a] != live_[b]) { return live_[a]; }
+		if (!live_[a]) { return a < b; }
+		if (less(heads_[a], heads_[b], comp_)) { return true; }
+		if (less(heads_[b], heads_[a], comp_)) { return false; }
+		return a < b;
+	}
+
+	const std::vector<T>& heads_;
+	const std::vector<bool>& live_;
+	const Comp& comp_;
+	size_t k_;
+	std::vector<size_t> tree_;
+};
+
+
+//------------------------------------------------------
+// External merge sort driver, parameterized by the record format.
+//
+// Memory: a chunk holds as many records as fit in memory_budget, counting
+// the array, each record's heap bytes, and room for half as many elements
+// again: the default chunk sort is tim_sort, which is stable and moves at
+// most half a chunk into its scratch buffer (a stable sort that needs more,
+// like merge_sort, would go over the budget).  The chunk is released before
+// its run takes part in a merge.  A run keeps no buffer between being
+// written and being merged.  A merge of k runs gives each run an equal
+// share of the budget as its read buffer.
+//
+// Stability: with a stable chunk sort, equal records come out in input
+// order, since the merges take ties from the run made first.  An unstable
+// sorter (intro_sort<T> needs no scratch) gives up only that.
+//
+// Open files: runs are kept in levels; when a level collects fan_in runs
+// they are merged into one run on the next level up, so there are never
+// more than about fan_in open temp files per level, and every record is
+// merged once per level.  fan_in is MAX_FAN_IN, or fewer when the budget
+// cannot give that many runs a read buffer of MIN_IO_BUFFER bytes.
+//
+// Temp files go to temp_dir, or to std::tmpfile()'s directory when it is
+// empty; point it at a disk, not a RAM-backed /tmp, for multi-GB inputs.
+// Errors (temp file creation, disk full) throw std::runtime_error*, like
+// the rest of the library.  Returns the number of records sorted.
+//------------------------------------------------------
+template <typename Format>
+class external_sort {
+public:
+	typedef typename Format::value_type T;
+	static constexpr size_t MAX_FAN_IN = 128;
+	static constexpr size_t MIN_IO_BUFFER = 1 << 14;
+	static constexpr size_t MAX_IO_BUFFER = 1 << 22;
+
+	template <typename Comp = fwd_comparator<T>, typename S = tim_sort<T>>
+	static size_t sort(std::istream& in, std::ostream& out, size_t memory_budget,
+		const Comp& comp = Comp(), const S& sorter = S(), const std::string& temp_dir = "") {
+		typedef std::vector<std::unique_ptr<run_file>> run_list;
+		std::vector<run_list> levels(1);
+		size_t io_buffer = std::max<size_t>(MIN_IO_BUFFER, std::min<size_t>(MAX_IO_BUFFER, memory_budget / 16));
+		size_t chunk_budget = memory_budget > 2 * io_buffer ? memory_budget - io_buffer : memory_budget / 2;
+		size_t fan_in = std::max<size_t>(2, std::min<size_t>(MAX_FAN_IN, memory_budget / 2 / MIN_IO_BUFFER));
+		size_t total = 0;
+
+		std::vector<T> chunk;
+		T record;
+		bool more = Format::read(in, record);
+		while (more) {
+			size_t heap = 0;
+			chunk.clear();
+			do {
+				// doubling holds both arrays for a moment: 3x, the same as sorting 2x with tim_sort's scratch
+				if (chunk.size() == chunk.capacity() && !chunk.empty()
+					&& 3 * chunk.capacity() * sizeof(T) + heap > chunk_budget) { break; }
+				heap += Format::heap_bytes(record);
+				chunk.push_back(std::move(record));
+				more = Format::read(in, record);
+			} while (more && 3 * chunk.size() * sizeof(T) / 2 + heap < chunk_budget);
+			total += chunk.size();
+
+			sorter.sort(chunk.data(), chunk.size(), comp);
+
+			if (!more && total == chunk.size()) {            // it all fit: no temp files
+				for (const T& v : chunk) { Format::write(out, v); }
+				return total;
+			}
+			run_file* run = new run_file(temp_dir, io_buffer);
+			levels[0].emplace_back(run);
+			for (const T& v : chunk) { Format::spill(*run, v); }
+			run->finish();
+
+			if (levels[0].size() == fan_in) { std::vector<T>().swap(chunk); }    // the merges below get the budget
+			for (size_t l = 0; levels[l].size() == fan_in; ++l) {
+				if (l + 1 == levels.size()) { levels.emplace_back(); }
+				levels[l + 1].emplace_back(merge_to_run(levels[l], memory_budget, io_buffer, comp, temp_dir));
+				levels[l].clear();
+			}
+		}
+		std::vector<T>().swap(chunk);                        // give the chunk's memory to the merge
+
+		// oldest runs first, so ties keep input order across runs
+		run_list runs;
+		for (size_t l = levels.size(); l-- > 0; ) {
+			for (std::unique_ptr<run_file>& run : levels[l]) { runs.push_back(std::move(run)); }
+		}
+		while (runs.size() > fan_in) {
+			run_list merged;
+			for (size_t i = 0; i < runs.size(); i += fan_in) {
+				run_list group;
+				for (size_t j = i; j < std::min(runs.size(), i + fan_in); ++j) { group.push_back(std::move(runs[j])); }
+				merged.emplace_back(merge_to_run(group, memory_budget, io_buffer, comp, temp_dir));
+			}
+			runs.swap(merged);
+		}
+		merge(runs, memory_budget, comp, [&out](const T& v) { Format::write(out, v); });
+		return total;
+	}
+
+private:
+	template <typename Comp>
+	static run_file* merge_to_run(std::vector<std::unique_ptr<run_file>>& runs, size_t budget, size_t io_buffer,
+		const Comp& comp, const std::string& temp_dir) {
+		run_file* dst = new run_file(temp_dir, io_buffer);
+		merge(runs, budget - std::min(budget / 2, io_buffer), comp, [dst](const T& v) { Format::spill(*dst, v); });
+		dst->finish();
+		runs.clear();
+		return dst;
+	}
+
+	template <typename Comp, typename Sink>
+	static void merge(std::vector<std::unique_ptr<run_file>>& runs, size_t budget, const Comp& comp, const Sink& sink) {
+		size_t k = runs.size();
+		if (k == 0) { return; }
+		size_t buffer = std::max<size_t>(MIN_IO_BUFFER, std::min<size_t>(MAX_IO_BUFFER, budget / 2 / k));
+		std::vector<T> heads(k);
+		std::vector<bool> live(k);
+		for (size_t i = 0; i < k; ++i) {
+			runs[i]->rewind(buffer);
+			live[i] = Format::load(*runs[i], heads[i]);
+		}
+
+		loser_tree<T, Comp> tree(heads, live, comp);
+		for (size_t s = tree.winner(); live[s]; s = tree.winner()) {
+			sink(heads[s]);
+			live[s] = Format::load(*runs[s], heads[s]);
+			tree.replay(s);
+		}
+	}
+};
+
+#endif /* External_Sort_h */
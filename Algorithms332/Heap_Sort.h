@@ -1,337 +1,332 @@
-//------------------------------------------------------
 //
-// Heap Sort and Max PQ Heap
-// The working Max PQ heap is mostly based off of the code provided by professor McCarthy.
-// My attempts can be found after that, commented out.
-// I was finding a bug where my integers were changing going into the less function and I could not find out where. 
-// Most likely this is due to not allocating the array.
+//  Heap_Sort.h
+//  Algorithms332
+//
+//  Heap-ordered arrays: heap_sort, an in-place heapsort (binary or 4-ary,
+//  bottom-up sifts), and index_pq, an indexed d-ary priority queue whose
+//  keys can be changed or removed by index.
 //
-//-------------------------------------------------------
 
-/*
-#include <iostream>
+#ifndef Heap_Sort_h
+#define Heap_Sort_h
+
 #include <cassert>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 #include "Utils.h"
-#include "Array.h"
 
-template <typename T>
+
+//------------------------------------------------------
+// In-place heapsort: O(n lg n) worst case and O(1) extra memory.
+//   - the heap is built bottom-up (Floyd), O(n) for the whole array
+//   - every sift is bottom-up: the hole at the top walks down to a leaf
+//     along the larger children without comparing against the sifted
+//     element, which then swims up from there.  Sifted elements come off
+//     the bottom of the heap and almost always belong near the bottom, so
+//     this costs about 1 comparison per level (Arity - 1 for the children)
+//     instead of 2 (Arity) for the textbook sink.
+//   - Arity is the number of children per node.  A 4-ary heap is half as
+//     deep, and the 4 children of a node sit next to each other, so each
+//     level of a sift touches one cache line instead of several.
+//------------------------------------------------------
+template <typename T, size_t Arity = 2>
 class heap_sort {
 public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>()) {// heapify phase
-		for (int k = n / 2; k >= 1; k--) {
-			sink(arr, k, n, comp);
+	static_assert(Arity == 2 || Arity == 4, "heap_sort supports binary and 4-ary heaps");
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp()) {
+		make_heap(arr, n, comp);
+		sort_heap(arr, n, comp);
+		assert(is_sorted(arr, n, comp));
+	}
+
+	// heapify phase: sift every parent, the last one first
+	template <typename Comp = fwd_comparator<T>>
+	static void make_heap(T* arr, size_t n, const Comp& comp = Comp()) {
+		if (n < 2) { return; }
+		for (size_t k = (n - 2) / Arity + 1; k-- > 0; ) {
+			T v = std::move(arr[k]);
+			count_moves(comp, 1);
+			sift(arr, k, n, std::move(v), comp);
 		}
+	}
 
-		// sortdown phase
-		int k = n;
-		while (k > 1) {
-			exch(arr, 1, k--);
-			sink(arr, 1, k, comp);
-			for (int i = 0; i < n; i++)
-			{
-				std::cout << arr[i] << " ";
-			}
-			std::cout << std::endl;
+	// sortdown phase: the max goes to the end, the last element is sifted from the root
+	template <typename Comp = fwd_comparator<T>>
+	static void sort_heap(T* arr, size_t n, const Comp& comp = Comp()) {
+		if (n < 2) { return; }
+		for (size_t m = n - 1; m > 0; --m) {
+			T v = std::move(arr[m]);
+			arr[m] = std::move(arr[0]);
+			count_moves(comp, 2);
+			sift(arr, 0, m, std::move(v), comp);
 		}
+	}
 
-		assert(is_sorted(arr, n));
-	}&*/
+	// the heap arr[0..n)'s top has been moved out: v takes its place and sifts down
+	template <typename Comp = fwd_comparator<T>>
+	static void replace_top(T* arr, size_t n, T&& v, const Comp& comp = Comp()) {
+		sift(arr, 0, n, std::move(v), comp);
+	}
 
-	/***************************************************************************
-	 * Helper functions to restore the heap invariant.
-	 ***************************************************************************/
+private:
+	// places v in the heap arr[0..n) whose node k is a hole (every other node in k's subtree in order)
+	template <typename Comp>
+	static void sift(T* arr, size_t k, size_t n, T&& v, const Comp& comp) {
+		size_t hole = k, moves = 1;
+		for (size_t child = Arity * hole + 1; child < n; child = Arity * hole + 1) {
+			hole = largest_child(arr, child, n, comp);
+			arr[(hole - 1) / Arity] = std::move(arr[hole]);
+			++moves;
+		}
 
-/*private:
-	static void sink(T* arr, int k, int n, const comparator<T>& comp = fwd_comparator<T>()) {
-		while ((2 * k) <= n) 
-		{
-			int j = (2 * k);
+		while (hole > k) {
+			size_t parent = (hole - 1) / Arity;
+			if (!less(arr[parent], v, comp)) { break; }
+			arr[hole] = std::move(arr[parent]);
+			hole = parent;
+			++moves;
+		}
+		arr[hole] = std::move(v);
+		count_moves(comp, moves);
+	}
 
-			if ((j < n) && less(arr[j-1], arr[j], comp))
-			{
-				j++;
+	template <typename Comp>
+	static size_t largest_child(const T* arr, size_t first, size_t n, const Comp& comp) {
+		size_t largest = first;
+		if (first + Arity <= n) {                    // all children present: fixed-length, unrolled
+			for (size_t i = 1; i < Arity; ++i) {
+				largest = less(arr[largest], arr[first + i], comp) ? first + i : largest;
 			}
-
-			if (!less(arr[k-1], arr[j-1], comp))
-			{
-				break;
+		}
+		else {
+			for (size_t i = first + 1; i < n; ++i) {
+				if (less(arr[largest], arr[i], comp)) { largest = i; }
 			}
-			
-			exch(arr, k, j);
-
-			k = j;
 		}
-	}*/
-
-	/***************************************************************************
-	 * Helper functions for comparisons and swaps.
-	 * Indices are "off-by-one" to support 1-based indexing.
-	 ***************************************************************************/
-	/*static void exch(T* arr, int i, int j) {
-		T swap = arr[i - 1];
-		arr[i - 1] = arr[j - 1];
-		arr[j - 1] = swap;
+		return largest;
 	}
 };
 
 
-#define MIN_CAPACITY 3
-
 //------------------------------------------------------
-template <typename T>
-class max_pq_heap {
-public:
-	max_pq_heap(const comparator<T>& compar = fwd_comparator<T>) {};
-	max_pq_heap(const comparator<T>& compar) : max_pq_heap(MIN_CAPACITY, compar) { }
-
-	max_pq_heap(size_t capacity, const comparator<T>& compar)
-		: pq_(capacity + 1), comp(compar) {
-		pq_.push_back(T());
-	}  // make space for skipped-over 0 entry
-
-	max_pq_heap(const std::initializer_list<T>& li, const comparator<T>& compar)
-		: max_pq_heap(li.size(), compar) {
-		for (const T& el : li) {
-			if (el != "-") {
-				insert(el);
-			}
-			else { std::cout << delMax() << " "; }
-		}
-		std::cout << "\t(" << size() << " left on the heap)\n\n"; \
-	}
+// Indexed priority queue: every key is associated with a client index in
+// [0, capacity), so a key already in the queue can be found by its index
+// and changed or removed in O(log n) -- e.g., the tentative distances of
+// Dijkstra's algorithm, or the deadlines of a scheduler's tasks.
+//   - the heap is one contiguous array of (key, index) entries, plus an
+//     index -> heap position map that every move keeps up to date
+//   - Order::max keeps the largest key (by comp) on top, Order::min the
+//     smallest; decrease_key/increase_key mean smaller/larger by comp in
+//     both, as in Sedgewick's IndexMaxPQ and IndexMinPQ
+//   - Arity 2, 4 or 8: wider heaps are shallower, and a node's children
+//     are adjacent, so a sift reads fewer cache lines per level
+//   - pop() uses heap_sort's bottom-up sift, heapify() Floyd's O(n) build
+//------------------------------------------------------
+enum class heap_order { max, min };
 
-	bool empty() const { return pq_.size() == 1; }   // leaves 0 index empty
-	size_t size() const { return pq_.size() - 1; }   // ditto
+template <typename T, heap_order Order = heap_order::max, size_t Arity = 2, typename Comp = fwd_comparator<T>>
+class index_pq {
+public:
+	static_assert(Arity == 2 || Arity == 4 || Arity == 8, "index_pq supports 2-, 4- and 8-ary heaps");
 
-	void insert(const T& value) {
-		pq_.push_back(value);
-		swim(size());
-	}
-	T delMax() {
-		T maximum = pq_[1];
-		size_t n = size();
-
-		exchange(1, n);
-		pq_.pop_back();
-		sink(1);
-		pq_[n] = T();
-		return maximum;
+	explicit index_pq(size_t capacity, const Comp& comp = Comp())
+		: pos_(capacity, NONE), comp_(comp) {
+		heap_.reserve(capacity);
 	}
-	void swim(size_t k) {
-		while (k > 1 && less(k / 2, k)) {
-			exchange(k, k / 2);
-			k /= 2;
-		}
-	}
-	void sink(size_t k) {
-		size_t n = size();
 
-		while (2 * k <= n) {
-			size_t j = 2 * k;
-			if (j < n && less(j, j + 1)) { ++j; }
-			if (!less(k, j)) { break; }
+	bool empty() const { return heap_.empty(); }
+	size_t size() const { return heap_.size(); }
+	size_t capacity() const { return pos_.size(); }
+	bool contains(size_t i) const { return i < pos_.size() && pos_[i] != NONE; }
 
-			exchange(k, j);
-			k = j;
-		}
-	}
-	friend std::ostream& operator<<(std::ostream& os, const max_pq_heap& maxpq) {
-		if (maxpq.empty()) { return os << "max_pq_heap is empty\n"; }
-		return os << maxpq.pq_ << "\n";
+	void clear() {
+		for (const entry& e : heap_) { pos_[e.index] = NONE; }
+		heap_.clear();
 	}
 
-	void printPQ() {
-		size_t n = size();
+	// replaces the contents with keys[i] at index i, for i in [0, n)
+	void heapify(const T* keys, size_t n) {
+		if (n > capacity()) { throw new std::overflow_error("heapify: more keys than index_pq capacity\n"); }
+		clear();
 		for (size_t i = 0; i < n; ++i) {
-			std::cout << pq_[i] << " ";
+			heap_.push_back(entry{ keys[i], i });
+			pos_[i] = i;
+		}
+		if (n < 2) { return; }
+		for (size_t k = (n - 2) / Arity + 1; k-- > 0; ) {
+			entry e = std::move(heap_[k]);
+			sift_bottom_up(k, std::move(e));
 		}
-		std::cout << '\n';
+		assert(check());
 	}
 
-	
-
-private:
-	static const size_t MIN_CAPACITY_;
-
-	void exchange(size_t i, size_t j) {
-		T temp = pq_[i];
-		pq_[i] = pq_[j];
-		pq_[j] = temp;
+	void insert(size_t i, T key) {
+		check_index(i);
+		if (contains(i)) { throw new std::invalid_argument("index is already in the index_pq\n"); }
+		heap_.push_back(entry{ std::move(key), i });
+		entry e = std::move(heap_.back());
+		swim(heap_.size() - 1, std::move(e));
 	}
 
-	bool less(size_t i, size_t j) {
-		return ::less(pq_[i], pq_[j], comp);
+	size_t top_index() const {
+		if (empty()) { throw new std::underflow_error("top of an empty index_pq\n"); }
+		return heap_[0].index;
 	}
-
-	array_<T> pq_;                // uses expandable array from array.h, not std::array<T>
-	const comparator<T>& comp;
-};*/
-
-
-
-//-----------------------------------------------------
-//MY ATTEMPT AT MAX_PQ_HEAP
-//-----------------------------------------------------
-
-/*template <typename T>
-class max_pq_heap {
-private:
-
-
-public:
-
-
-	static bool isEmpty(array_<T>& myPQ) {
-		return(myPQ.size() == 1);
+	const T& top_key() const {
+		if (empty()) { throw new std::underflow_error("top of an empty index_pq\n"); }
+		return heap_[0].key;
 	}
-
-
-	static int size(array_<T>& myPQ) {
-		return(myPQ.size());
+	const T& key_of(size_t i) const { return heap_[position(i)].key; }
+
+	// removes the top key and returns its index
+	size_t pop() {
+		size_t i = top_index();
+		pos_[i] = NONE;
+		entry last = std::move(heap_.back());
+		heap_.pop_back();
+		if (!heap_.empty()) { sift_bottom_up(0, std::move(last)); }
+		return i;
 	}
 
-
-	static T max(array_<T>& myPQ) {
-		if (isEmpty())
-		{
-			assert(false);
-		}
-		return (myPQ[1]);
+	void change_key(size_t i, T key) {
+		size_t h = position(i);
+		entry e{ std::move(key), i };
+		if (h > 0 && above(e.key, heap_[(h - 1) / Arity].key)) { swim(h, std::move(e)); }
+		else { sink(h, std::move(e)); }
 	}
 
-
-	static void insert(T x, array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		// add x, and percolate it up to maintain heap invariant
-		myPQ.push_back(x);
-
-		for (int i = 1; i < myPQ.size(); i++)
-		{
-			std::cout << myPQ[i] << " ";
-		}
-		std::cout << std::endl;
-		swim(myPQ.size()-1, myPQ, comp);
-
-		assert(isMaxHeap(myPQ, comp));
+	// key must not be larger (by comp) than the current key of i
+	void decrease_key(size_t i, T key) {
+		size_t h = position(i);
+		if (less(heap_[h].key, key, comp_)) { throw new std::invalid_argument("decrease_key would increase the key\n"); }
+		entry e{ std::move(key), i };
+		if (Order == heap_order::min) { swim(h, std::move(e)); }
+		else { sink(h, std::move(e)); }
 	}
 
+	// key must not be smaller (by comp) than the current key of i
+	void increase_key(size_t i, T key) {
+		size_t h = position(i);
+		if (less(key, heap_[h].key, comp_)) { throw new std::invalid_argument("increase_key would decrease the key\n"); }
+		entry e{ std::move(key), i };
+		if (Order == heap_order::max) { swim(h, std::move(e)); }
+		else { sink(h, std::move(e)); }
+	}
 
-	static T delMax(array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		if (isEmpty(myPQ))
-		{
-			assert(false);
-		}
-		exch(0, myPQ.size()-1, myPQ);
-		sink(0, myPQ, comp);
-		T max = myPQ.pop_back();    // to avoid loitering and help with garbage collection
-		//assert(isMaxHeap(myPQ, comp));
-		return max;
+	void erase(size_t i) {
+		size_t h = position(i);
+		pos_[i] = NONE;
+		entry last = std::move(heap_.back());
+		heap_.pop_back();
+		if (h == heap_.size()) { return; }                 // i was the last entry
+		if (h > 0 && above(last.key, heap_[(h - 1) / Arity].key)) { swim(h, std::move(last)); }
+		else { sink(h, std::move(last)); }
 	}
 
-	// helper function to double the size of the heap array
 private:
+	struct entry {
+		T key;
+		size_t index;
+	};
 
+	static constexpr size_t NONE = size_t(-1);
 
-
-	static void swim(int k, array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		while (k > 1) {
-			for (int i = 1; i < myPQ.size(); i++)
-			{
-				std::cout << myPQ[i] << " ";
-			}
-			std::cout << std::endl;
-			if (less((k / 2), k, myPQ, comp))
-			{
-				exch(k, (k / 2), myPQ);
-				k = k / 2;
-			}
-			else {
-				break;
-			}
-		}
+	// a belongs above b in the heap
+	bool above(const T& a, const T& b) const {
+		return Order == heap_order::max ? less(b, a, comp_) : less(a, b, comp_);
 	}
 
-	static void sink(int k, array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		while (2 * k <= myPQ.size()) {
-			int j = 2 * k;
-
-			if (j < myPQ.size() && less(j, j+1, myPQ, comp))
-			{
-				j++;
-			}
-			if (!less(k, j, myPQ, comp)) {
-				break;
-			}
-			exch(k, j, myPQ);
-			k = j;
-		}
+	void check_index(size_t i) const {
+		if (i >= pos_.size()) { throw new std::invalid_argument("index out of range for index_pq\n"); }
 	}
 
+	size_t position(size_t i) const {
+		if (!contains(i)) { throw new std::invalid_argument("index is not in the index_pq\n"); }
+		return pos_[i];
+	}
 
-	static void exch(int i, int j, array_<T>& myPQ) {
-		T swap = myPQ[i];
-		myPQ[i] = myPQ[j];
-		myPQ[j] = swap;
+	void place(size_t h, entry&& e) {
+		pos_[e.index] = h;
+		heap_[h] = std::move(e);
 	}
 
-	// is myPQ[1..n] a max heap?
-	static bool isMaxHeap(array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		for (int i = 1; i < size(); ++i) {
-			if (myPQ[i] == null) {
-				return false;
+	// the child of the first..first+Arity siblings that belongs highest
+	size_t top_child(size_t first) const {
+		size_t n = heap_.size(), best = first;
+		if (first + Arity <= n) {                    // all children present: fixed-length, unrolled
+			for (size_t c = first + 1; c < first + Arity; ++c) {
+				best = above(heap_[c].key, heap_[best].key) ? c : best;
 			}
 		}
-		if (isEmpty(myPQ))
-		{
-			return false;
+		else {
+			for (size_t c = first + 1; c < n; ++c) {
+				best = above(heap_[c].key, heap_[best].key) ? c : best;
+			}
 		}
-		return isMaxHeapOrdered(1, myPQ, comp);
+		return best;
 	}
 
-	// is subtree of myPQ[1..n] rooted at k a max heap?
-	static bool isMaxHeapOrdered(int k, array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		if (k >= myPQ.size())
-		{
-			return true;
-		}
-		int left = 2 * k;
-		int right = 2 * k + 1;
-
-		if (left < myPQ.size()) {
-			if(less(k, left, myPQ, comp))
-			{
-				return false;
-			}
-		}
-		if (right < myPQ.size()) {
-			if (less(k, right, myPQ, comp))
-			{
-				return false;
-			}
+	// places e at or above the hole h
+	void swim(size_t h, entry&& e) {
+		while (h > 0) {
+			size_t parent = (h - 1) / Arity;
+			if (!above(e.key, heap_[parent].key)) { break; }
+			place(h, std::move(heap_[parent]));
+			h = parent;
 		}
-		return (isMaxHeapOrdered(left, myPQ, comp) && isMaxHeapOrdered(right, myPQ, comp));
+		place(h, std::move(e));
 	}
 
-	static bool less(size_t i, size_t j, array_<T>& myPQ, const comparator<T>& comp = fwd_comparator<T>()) {
-		return ::less(myPQ[i], myPQ[j], comp);
+	// places e at or below the hole h
+	void sink(size_t h, entry&& e) {
+		for (size_t first = Arity * h + 1; first < heap_.size(); first = Arity * h + 1) {
+			size_t child = top_child(first);
+			if (!above(heap_[child].key, e.key)) { break; }
+			place(h, std::move(heap_[child]));
+			h = child;
+		}
+		place(h, std::move(e));
 	}
 
-public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>()) {
-		array_<T> myPQ;
-		myPQ.push_back(T());
-		for (int i = 1; i < n; i++)
-		{
-			insert(arr[i], myPQ, comp);
+	// places e in the subtree of the hole k: the hole walks down to a leaf, e swims up from there
+	void sift_bottom_up(size_t k, entry&& e) {
+		size_t h = k;
+		for (size_t first = Arity * h + 1; first < heap_.size(); first = Arity * h + 1) {
+			size_t child = top_child(first);
+			place(h, std::move(heap_[child]));
+			h = child;
 		}
-		for (int k = myPQ.size() / 2; k >= 1; k--)
-		{
-			sink(k, myPQ, comp);
+		while (h > k) {
+			size_t parent = (h - 1) / Arity;
+			if (!above(e.key, heap_[parent].key)) { break; }
+			place(h, std::move(heap_[parent]));
+			h = parent;
 		}
+		place(h, std::move(e));
+	}
 
-		myPQ.size();
-		for (int i = 0; i < n; i++)
-		{
-			arr[i] = delMax(myPQ, comp);
+	// heap order holds and pos_ is the inverse of heap_'s indices
+	bool check() const {
+		for (size_t h = 0; h < heap_.size(); ++h) {
+			if (pos_[heap_[h].index] != h) { return false; }
+			if (h > 0 && above(heap_[h].key, heap_[(h - 1) / Arity].key)) { return false; }
 		}
+		return true;
 	}
-};*/
+
+	std::vector<entry> heap_;
+	std::vector<size_t> pos_;          // heap position of each index, NONE if absent
+	Comp comp_;
+};
+
+template <typename T, size_t Arity = 2, typename Comp = fwd_comparator<T>>
+using index_max_pq = index_pq<T, heap_order::max, Arity, Comp>;
+
+template <typename T, size_t Arity = 2, typename Comp = fwd_comparator<T>>
+using index_min_pq = index_pq<T, heap_order::min, Arity, Comp>;
+
+
+#endif /* Heap_Sort_h */
@@ -16,16 +16,25 @@
 template <typename T>
 class insertion_sort {
 public:
-	static void sort(T* arr, size_t low, size_t high, const comparator<T>& comp = fwd_comparator<T>()) {
-		for (size_t i = low; i <= high; ++i) {
-			for (size_t j = i; j > 0; --j) {
-				if (less(arr[j], arr[j - 1], comp)) { exchange(arr, j, j - 1); }
-				else { break; }
-			}
+	// sorts arr[low..high] -- high is inclusive
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t low, size_t high, const Comp& comp = Comp()) {
+		for (size_t i = low + 1; i <= high; ++i) {
+			if (!less(arr[i], arr[i - 1], comp)) { continue; }
+			T v = std::move(arr[i]);                 // shift the larger ones right into the hole
+			size_t j = i;
+			do {
+				arr[j] = std::move(arr[j - 1]);
+				--j;
+			} while (j > low && less(v, arr[j - 1], comp));
+			arr[j] = std::move(v);
+			count_moves(comp, i - j + 2);
 		}
-		assert(is_sorted(arr, low, high, comp));
+		assert(is_sorted(arr, low, high + 1, comp));
 	}
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>()) {
+	template <typename Comp = fwd_comparator<T>, if_comparator<Comp, T> = 0>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp()) {
+		if (n < 2) { return; }
 		sort(arr, 0, n - 1, comp);
 	}
 };
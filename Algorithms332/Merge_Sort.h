@@ -11,28 +11,50 @@
 
 #include <cassert>
 #include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
 #include "Utils.h"
 #include "Insertion_Sort.h"
+#include "Sorting_Network.h"
 
 template <typename T>
 class merge_sort {
 	public:
-		static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>())
+		template <typename Comp = fwd_comparator<T>>
+		static void sort(T* arr, size_t n, const Comp& comp = Comp())
 		{
+			if (n < 2) { return; }
 			T *aux = new T[n];
+			count_scratch(comp, n * sizeof(T));
 			sort(arr, aux, 0, n - 1, comp);
 			delete[] aux;
 		}
 
+		// the same, with the caller's scratch space aux[0..n) instead of a new array
+		template <typename Comp>
+		static void sort(T* arr, size_t n, const Comp& comp, T* aux)
+		{
+			if (n < 2) { return; }
+			sort(arr, aux, 0, n - 1, comp);
+		}
+
 private:
 		static const int CUTOFF = 7;
 
-		static void sort(T* arr, T* aux, size_t low, size_t high, const comparator<T>& comp)
+		template <typename Comp>
+		static void sort(T* arr, T* aux, size_t low, size_t high, const Comp& comp)
 		{
+			recursion_depth<Comp> depth(comp);
+			if constexpr (use_stable_sorting_network<T, Comp>::value) {
+				if (high - low < sorting_network<T>::MAX) {
+					sorting_network<T>::sort_unchecked(arr + low, high - low + 1);
+					return;
+				}
+			}
 			//check that the size is not 0 or 1
 			if (high <= low + CUTOFF) {
-				insertion_sort<std::string> ins_sort;
-				ins_sort.sort(arr, low, high, comp);
+				insertion_sort<T>::sort(arr, low, high, comp);
 				return;
 			}
 
@@ -42,33 +64,39 @@ private:
 			merge(arr, aux, low, mid, high, comp);
 		}
 
-		static void merge(T* arr, T* aux, size_t low, size_t mid, size_t high, const comparator<T>& comp)
+		template <typename Comp>
+		static void merge(T* arr, T* aux, size_t low, size_t mid, size_t high, const Comp& comp)
 		{
 			int i = low; 
 			int j = mid + 1;
 
 			for (int k = low; k <= high; k++)
 			{
-				// Copy a[lo..hi] to aux[lo..hi].
-				aux[k] = arr[k];
+				// Move a[lo..hi] to aux[lo..hi].
+				aux[k] = std::move(arr[k]);
+			}
+			count_moves(comp, 2 * (high - low + 1));
+
+			if constexpr (use_stable_sorting_network<T, Comp>::value && simd_merge<T>::supported) {
+				if (simd_merge<T>::merge(aux + low, mid - low + 1, aux + mid + 1, high - mid, arr + low)) { return; }
 			}
 
 			for (int k = low; k <= high; k++)
 			{
 				// Merge back to a[lo..hi].
 				if (i > mid) {
-					arr[k] = aux[j++];
+					arr[k] = std::move(aux[j++]);
 				}
 				else if (j > high) 
 				{
-					arr[k] = aux[i++];
+					arr[k] = std::move(aux[i++]);
 				}
 				else if (less(aux[j], aux[i], comp))
 				{
-					arr[k] = aux[j++];
+					arr[k] = std::move(aux[j++]);
 				}
 				else {
-					arr[k] = aux[i++];
+					arr[k] = std::move(aux[i++]);
 				}
 			}
 		}
@@ -79,10 +107,12 @@ class merge_bu_sort {
 	public:
 		// merge_bu_sort() = delete;
 
-		static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>())
+		template <typename Comp = fwd_comparator<T>>
+		static void sort(T* arr, size_t n, const Comp& comp = Comp())
 		{
 			// Do lg N passes of pairwise merges.
 			T *aux = new T[n];
+			count_scratch(comp, n * sizeof(T));
 			for (size_t sz = 1; sz < n; sz = sz + sz) // sz: subarray size
 			{
 				for (size_t lo = 0; lo < n - sz; lo += sz + sz) // lo: subarray index
@@ -90,37 +120,427 @@ class merge_bu_sort {
 					merge(arr, aux, lo, lo + sz - 1, std::min<size_t>(lo + 2 * sz - 1, n - 1), comp);
 				}
 			}
+			delete[] aux;
 		}
 
 	private:
-		static void merge(T* arr, T* aux, size_t low, size_t mid, size_t high, const comparator<T>& comp)
+		template <typename Comp>
+		static void merge(T* arr, T* aux, size_t low, size_t mid, size_t high, const Comp& comp)
 		{
 			int i = low;
 			int j = mid + 1;
 
 			for (int k = low; k <= high; k++)
 			{
-				// Copy a[lo..hi] to aux[lo..hi].
-				aux[k] = arr[k];
+				// Move a[lo..hi] to aux[lo..hi].
+				aux[k] = std::move(arr[k]);
 			}
+			count_moves(comp, 2 * (high - low + 1));
 
 			for (int k = low; k <= high; k++)
 			{
 				// Merge back to a[lo..hi].
 				if (i > mid) {
-					arr[k] = aux[j++];
+					arr[k] = std::move(aux[j++]);
 				}
 				else if (j > high)
 				{
-					arr[k] = aux[i++];
+					arr[k] = std::move(aux[i++]);
 				}
 				else if (less(aux[j], aux[i], comp))
 				{
-					arr[k] = aux[j++];
+					arr[k] = std::move(aux[j++]);
 				}
 				else {
-					arr[k] = aux[i++];
+					arr[k] = std::move(aux[i++]);
+				}
+			}
+		}
+};
+
+//------------------------------------------------------
+// Reusable scratch space for the merge sorts.  get(n) only allocates when
+// asked for more than it has ever handed out, so sorting in a loop
+// allocates once.  thread_local_buffer() is one buffer per thread and
+// element type, for callers that do not want to keep their own.
+//------------------------------------------------------
+template <typename T>
+class merge_buffer {
+	public:
+		merge_buffer() : data_(nullptr), capacity_(0) { }
+		~merge_buffer() { delete[] data_; }
+
+		merge_buffer(const merge_buffer&) = delete;
+		merge_buffer& operator=(const merge_buffer&) = delete;
+
+		T* get(size_t n)
+		{
+			if (n > capacity_)
+			{
+				delete[] data_;
+				data_ = new T[n];
+				capacity_ = n;
+			}
+			return data_;
+		}
+		size_t capacity() const { return capacity_; }
+
+		static merge_buffer& thread_local_buffer()
+		{
+			static thread_local merge_buffer buffer;
+			return buffer;
+		}
+
+	private:
+		T* data_;
+		size_t capacity_;
+};
+
+//------------------------------------------------------
+// merge_sort without the per-merge copy into aux.  arr and aux swap roles
+// at every level: sort(src, dst) sorts both halves into src and merges them
+// straight into dst.  The data starts out in arr only; a leaf whose dst is
+// aux first moves its elements across.  Scratch space comes from a
+// merge_buffer, so repeated sorts allocate nothing.
+//------------------------------------------------------
+template <typename T>
+class merge_pp_sort {
+	public:
+		template <typename Comp = fwd_comparator<T>>
+		static void sort(T* arr, size_t n, const Comp& comp = Comp())
+		{
+			sort(arr, n, comp, merge_buffer<T>::thread_local_buffer());
+		}
+
+		template <typename Comp>
+		static void sort(T* arr, size_t n, const Comp& comp, merge_buffer<T>& buffer)
+		{
+			if (n < 2) { return; }
+			size_t had = buffer.capacity();
+			T* aux = buffer.get(n);
+			if (buffer.capacity() != had) { count_scratch(comp, n * sizeof(T)); }
+			sort(aux, arr, 0, n - 1, true, comp);
+			assert(is_sorted(arr, n, comp));
+		}
+
+	private:
+		static const int CUTOFF = 7;
+
+		// sorts src[low..high] into dst[low..high]; on entry the elements are in dst
+		// if in_dst, else in src
+		template <typename Comp>
+		static void sort(T* src, T* dst, size_t low, size_t high, bool in_dst, const Comp& comp)
+		{
+			recursion_depth<Comp> depth(comp);
+			bool leaf = high <= low + CUTOFF;
+			if constexpr (use_stable_sorting_network<T, Comp>::value) { leaf = high - low < sorting_network<T>::MAX; }
+			if (leaf)
+			{
+				if (!in_dst) {
+					std::move(src + low, src + high + 1, dst + low);
+					count_moves(comp, high - low + 1);
+				}
+				if constexpr (use_stable_sorting_network<T, Comp>::value) { sorting_network<T>::sort_unchecked(dst + low, high - low + 1); }
+				else { insertion_sort<T>::sort(dst, low, high, comp); }
+				return;
+			}
+
+			size_t mid = low + (high - low) / 2;
+			sort(dst, src, low, mid, !in_dst, comp);
+			sort(dst, src, mid + 1, high, !in_dst, comp);
+			merge(src, dst, low, mid, high, comp);
+		}
+
+		template <typename Comp>
+		static void merge(T* src, T* dst, size_t low, size_t mid, size_t high, const Comp& comp)
+		{
+			count_moves(comp, high - low + 1);
+			if constexpr (use_stable_sorting_network<T, Comp>::value && simd_merge<T>::supported) {
+				if (simd_merge<T>::merge(src + low, mid - low + 1, src + mid + 1, high - mid, dst + low)) { return; }
+			}
+			size_t i = low, j = mid + 1;
+			for (size_t k = low; k <= high; k++)
+			{
+				if (i > mid) { dst[k] = std::move(src[j++]); }
+				else if (j > high) { dst[k] = std::move(src[i++]); }
+				else if (less(src[j], src[i], comp)) { dst[k] = std::move(src[j++]); }
+				else { dst[k] = std::move(src[i++]); }
+			}
+		}
+};
+
+//------------------------------------------------------
+// Natural-run mode of merge_bu_sort (Timsort).  Instead of lg n passes of
+// fixed power-of-two merges, the input is cut into the runs it already has:
+//   - a run is a non-descending or a strictly descending stretch (the
+//     latter is reversed in place, which keeps the sort stable); runs
+//     shorter than min_run() are extended with binary insertion sort
+//   - runs go on a stack that is merged whenever the lengths stop shrinking
+//     fast enough (Timsort's invariants, with the Auger et al. fix), so
+//     merges stay balanced
+//   - each merge first trims the parts of either run that are already in
+//     place, then copies only the shorter run into the scratch buffer; when
+//     one side keeps winning, it switches to galloping (exponential search)
+//     and moves whole blocks at a time
+// Nearly sorted input makes only a few long runs and sorts in close to
+// linear time.  Stable, like merge_sort.
+//------------------------------------------------------
+template <typename T>
+class tim_sort {
+	public:
+		static const size_t MIN_MERGE = 64;
+		static const size_t MIN_GALLOP = 7;
+
+		template <typename Comp = fwd_comparator<T>>
+		static void sort(T* arr, size_t n, const Comp& comp = Comp())
+		{
+			if (n < 2) { return; }
+			merge_state<Comp> ms(arr, comp);
+
+			size_t min_len = min_run(n);
+			for (size_t lo = 0; lo < n; )
+			{
+				size_t len = count_run(arr, lo, n, comp);
+				if (len < min_len)
+				{
+					size_t forced = std::min(min_len, n - lo);
+					binary_insertion_sort(arr, lo, lo + forced, lo + len, comp);
+					len = forced;
+				}
+				ms.push_run(lo, len);
+				ms.merge_collapse();
+				lo += len;
+			}
+			ms.merge_force_collapse();
+			assert(is_sorted(arr, n, comp));
+		}
+
+		// n itself below MIN_MERGE, otherwise a length in [MIN_MERGE/2, MIN_MERGE] such that
+		// n / min_run(n) is a power of two or just under one, so the final merges are balanced
+		static size_t min_run(size_t n)
+		{
+			size_t r = 0;
+			while (n >= MIN_MERGE)
+			{
+				r |= n & 1;
+				n >>= 1;
+			}
+			return n + r;
+		}
+
+	private:
+		template <typename Comp>
+		struct merge_state {
+			struct run { size_t base, len; };
+
+			merge_state(T* a, const Comp& c) : arr(a), comp(c), min_gallop(MIN_GALLOP) { }
+
+			void push_run(size_t base, size_t len) { runs.push_back({ base, len }); }
+
+			// keeps len[i-2] > len[i-1] + len[i] and len[i-1] > len[i] for the top of the stack
+			void merge_collapse()
+			{
+				while (runs.size() > 1)
+				{
+					size_t n = runs.size() - 2;
+					if ((n > 0 && runs[n - 1].len <= runs[n].len + runs[n + 1].len)
+						|| (n > 1 && runs[n - 2].len <= runs[n - 1].len + runs[n].len))
+					{
+						if (n > 0 && runs[n - 1].len < runs[n + 1].len) { --n; }
+						merge_at(n);
+					}
+					else if (runs[n].len <= runs[n + 1].len) { merge_at(n); }
+					else { break; }
+				}
+			}
+
+			void merge_force_collapse()
+			{
+				while (runs.size() > 1)
+				{
+					size_t n = runs.size() - 2;
+					if (n > 0 && runs[n - 1].len < runs[n + 1].len) { --n; }
+					merge_at(n);
+				}
+			}
+
+			// merges runs i and i + 1
+			void merge_at(size_t i)
+			{
+				size_t base1 = runs[i].base, len1 = runs[i].len;
+				size_t base2 = runs[i + 1].base, len2 = runs[i + 1].len;
+				runs[i].len = len1 + len2;
+				runs.erase(runs.begin() + i + 1);
+
+				// elements of run 1 that are <= run 2's first are already in place
+				size_t k = gallop(arr[base2], arr + base1, len1, true, false, comp);
+				base1 += k;
+				len1 -= k;
+				if (len1 == 0) { return; }
+
+				// and so are elements of run 2 that are >= run 1's last
+				len2 = gallop(arr[base1 + len1 - 1], arr + base2, len2, false, true, comp);
+				if (len2 == 0) { return; }
+
+				if (len1 <= len2) { merge_lo(base1, len1, len2); }
+				else { merge_hi(base1, len1, len2); }
+			}
+
+			// run 1 is the shorter: it goes to tmp and the merge fills arr from the left
+			void merge_lo(size_t base1, size_t len1, size_t len2)
+			{
+				T* a = to_tmp(arr + base1, len1);
+				size_t i = 0;                                      // next in run 1 (tmp)
+				size_t j = base1 + len1, j_end = j + len2;         // next in run 2 (arr)
+				size_t k = base1;                                  // next output; k <= j always
+
+				while (i < len1 && j < j_end)
+				{
+					size_t wins_a = 0, wins_b = 0;
+					while (i < len1 && j < j_end && wins_a < min_gallop && wins_b < min_gallop)
+					{
+						if (less(arr[j], a[i], comp)) { arr[k++] = std::move(arr[j++]);  ++wins_b;  wins_a = 0; }
+						else { arr[k++] = std::move(a[i++]);  ++wins_a;  wins_b = 0; }
+					}
+
+					while (i < len1 && j < j_end)
+					{
+						size_t count_a = gallop(arr[j], a + i, len1 - i, true, false, comp);
+						for (size_t c = 0; c < count_a; ++c) { arr[k++] = std::move(a[i++]); }
+						if (i == len1) { break; }
+
+						size_t count_b = gallop(a[i], arr + j, j_end - j, false, false, comp);
+						for (size_t c = 0; c < count_b; ++c) { arr[k++] = std::move(arr[j++]); }
+
+						if (min_gallop > 1) { --min_gallop; }
+						if (count_a < MIN_GALLOP && count_b < MIN_GALLOP) { break; }
+					}
+					min_gallop += 2;      // penalize leaving gallop mode
 				}
+				while (i < len1) { arr[k++] = std::move(a[i++]); }  // what is left of run 2 is already in place
+				count_moves(comp, len1 + (k - base1));
+			}
+
+			// run 2 is the shorter: it goes to tmp and the merge fills arr from the right
+			void merge_hi(size_t base1, size_t len1, size_t len2)
+			{
+				size_t base2 = base1 + len1;
+				T* b = to_tmp(arr + base2, len2);
+				size_t i = base2;                                  // run 1 remaining is arr[base1..i)
+				size_t j = len2;                                   // run 2 remaining is tmp[0..j)
+				size_t k = base2 + len2;                           // output fills arr[..k); k >= i always
+
+				while (i > base1 && j > 0)
+				{
+					size_t wins_a = 0, wins_b = 0;
+					while (i > base1 && j > 0 && wins_a < min_gallop && wins_b < min_gallop)
+					{
+						if (less(b[j - 1], arr[i - 1], comp)) { arr[--k] = std::move(arr[--i]);  ++wins_a;  wins_b = 0; }
+						else { arr[--k] = std::move(b[--j]);  ++wins_b;  wins_a = 0; }
+					}
+
+					while (i > base1 && j > 0)
+					{
+						size_t count_a = (i - base1) - gallop(b[j - 1], arr + base1, i - base1, true, true, comp);
+						for (size_t c = 0; c < count_a; ++c) { arr[--k] = std::move(arr[--i]); }
+						if (i == base1) { break; }
+
+						size_t count_b = j - gallop(arr[i - 1], b, j, false, true, comp);
+						for (size_t c = 0; c < count_b; ++c) { arr[--k] = std::move(b[--j]); }
+
+						if (min_gallop > 1) { --min_gallop; }
+						if (count_a < MIN_GALLOP && count_b < MIN_GALLOP) { break; }
+					}
+					min_gallop += 2;
+				}
+				while (j > 0) { arr[--k] = std::move(b[--j]); }     // what is left of run 1 is already in place
+				count_moves(comp, len2 + (base2 + len2 - k));
+			}
+
+			// moves first[0..len) into tmp, which only grows
+			T* to_tmp(T* first, size_t len)
+			{
+				size_t had = tmp.capacity();
+				tmp.assign(std::make_move_iterator(first), std::make_move_iterator(first + len));
+				if (tmp.capacity() != had) { count_scratch(comp, tmp.capacity() * sizeof(T)); }
+				return tmp.data();
+			}
+
+			T* arr;
+			const Comp& comp;
+			size_t min_gallop;
+			std::vector<run> runs;
+			std::vector<T> tmp;
+		};
+
+		// Position of key in the sorted a[0..n): the first element not less than key
+		// (upper == false, lower bound) or the first element greater than key (upper == true,
+		// upper bound).  Exponential search from the left or right end, then binary search,
+		// so the cost is logarithmic in the distance from that end.
+		template <typename Comp>
+		static size_t gallop(const T& key, const T* a, size_t n, bool upper, bool from_right, const Comp& comp)
+		{
+			// true while a[x] belongs before the insertion point
+			auto before = [&](size_t x) { return upper ? !less(key, a[x], comp) : less(a[x], key, comp); };
+
+			size_t lo, hi;
+			if (!from_right)
+			{
+				if (n == 0 || !before(0)) { return 0; }
+				size_t last = 0, ofs = 1;
+				while (ofs < n && before(ofs)) { last = ofs;  ofs = 2 * ofs + 1; }
+				lo = last + 1;
+				hi = std::min(ofs, n);
+			}
+			else
+			{
+				if (n == 0 || before(n - 1)) { return n; }
+				size_t last = n - 1, ofs = 1;
+				while (ofs < n && !before(n - 1 - ofs)) { last = n - 1 - ofs;  ofs = 2 * ofs + 1; }
+				lo = ofs < n ? n - ofs : 0;
+				hi = last;
+			}
+
+			while (lo < hi)
+			{
+				size_t mid = lo + (hi - lo) / 2;
+				if (before(mid)) { lo = mid + 1; }
+				else { hi = mid; }
+			}
+			return lo;
+		}
+
+		// length of the run starting at lo; a strictly descending run is reversed first
+		template <typename Comp>
+		static size_t count_run(T* arr, size_t lo, size_t n, const Comp& comp)
+		{
+			size_t hi = lo + 1;
+			if (hi == n) { return 1; }
+
+			if (less(arr[hi], arr[lo], comp))
+			{
+				while (hi < n && less(arr[hi], arr[hi - 1], comp)) { ++hi; }
+				std::reverse(arr + lo, arr + hi);
+				count_swaps(comp, (hi - lo) / 2);
+			}
+			else
+			{
+				while (hi < n && !less(arr[hi], arr[hi - 1], comp)) { ++hi; }
+			}
+			return hi - lo;
+		}
+
+		// sorts arr[lo..hi) given that arr[lo..start) is already sorted
+		template <typename Comp>
+		static void binary_insertion_sort(T* arr, size_t lo, size_t hi, size_t start, const Comp& comp)
+		{
+			for (size_t i = start; i < hi; ++i)
+			{
+				T pivot = std::move(arr[i]);
+				size_t pos = lo + gallop(pivot, arr + lo, i - lo, true, true, comp);
+				for (size_t k = i; k > pos; --k) { arr[k] = std::move(arr[k - 1]); }
+				arr[pos] = std::move(pivot);
+				count_moves(comp, i - pos + 2);
 			}
 		}
 };
@@ -0,0 +1,347 @@
+//
+//  Parallel_Sort.h
+//  Algorithms332
+//
+//  Multi-threaded sorts built on the work_stealing_pool in Thread_Pool.h.
+//  Every sort takes the usual (arr, n, comp) plus a thread count (0 means
+//  one per hardware thread) or an existing pool to reuse across calls.
+//  If the comparator throws, the exception reaches the caller once the
+//  running tasks are done, and arr is left in an unspecified order.
+//
+
+#ifndef Parallel_Sort_h
+#define Parallel_Sort_h
+
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Utils.h"
+#include "Merge_Sort.h"
+#include "Quick_Sort.h"
+#include "Random.h"
+#include "Thread_Pool.h"
+
+
+//------------------------------------------------------
+// Parallel quicksort: each partition forks its left side as a pool task
+// and keeps the right side.  Pivots come from intro_sort::choose_pivot (no
+// serial shuffle), subarrays below SEQUENTIAL_CUTOFF are finished with
+// intro_sort, and so are subarrays whose splits have gone 2 lg n deep.
+// sort() uses quick_sort's 2-way partition (block_partition for primitive
+// keys), sort_3way() uses
+// quick_sort_3way's, which keeps runs of equal keys out of both halves.
+//------------------------------------------------------
+template <typename T>
+class parallel_quick_sort {
+public:
+	static const int SEQUENTIAL_CUTOFF = 1 << 14;
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp(), size_t threads = 0) {
+		work_stealing_pool pool(threads);
+		sort(arr, n, comp, pool);
+	}
+
+	template <typename Comp>
+	static void sort(T* arr, size_t n, const Comp& comp, work_stealing_pool& pool) {
+		run(arr, n, comp, pool, false);
+	}
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort_3way(T* arr, size_t n, const Comp& comp = Comp(), size_t threads = 0) {
+		work_stealing_pool pool(threads);
+		sort_3way(arr, n, comp, pool);
+	}
+
+	template <typename Comp>
+	static void sort_3way(T* arr, size_t n, const Comp& comp, work_stealing_pool& pool) {
+		run(arr, n, comp, pool, true);
+	}
+
+private:
+	template <typename Comp>
+	static void run(T* arr, size_t n, const Comp& comp, work_stealing_pool& pool, bool three_way) {
+		if (n < 2) return;
+		int depth_limit = 0;
+		for (size_t m = n; m >>= 1; ) { depth_limit += 2; }
+
+		task_group group(pool);
+		sort(arr, 0, int(n - 1), depth_limit, three_way, comp, group);
+		group.wait();
+		assert(is_sorted(arr, n, comp));
+	}
+
+	template <typename Comp>
+	static void sort(T* arr, int low, int high, int depth_limit, bool three_way,
+		const Comp& comp, task_group& group) {
+		while (high - low >= SEQUENTIAL_CUTOFF && depth_limit-- > 0) {
+			exchange(arr, low, intro_sort<T>::choose_pivot(arr, low, high, comp));
+
+			int lt, gt;
+			if (three_way) { quick_sort_3way<T>::partition(arr, low, high, lt, gt, comp); }
+			else if (use_block_partition<T>::value) { lt = gt = quick_sort<T>::block_partition(arr, low, high, comp); }
+			else { lt = gt = quick_sort<T>::partition(arr, low, high, comp); }
+
+			int left_high = lt - 1;
+			group.run([=, &comp, &group] {
+				sort(arr, low, left_high, depth_limit, three_way, comp, group);
+			});
+			low = gt + 1;
+		}
+		if (low < high) { intro_sort<T>::sort(arr + low, size_t(high - low + 1), comp); }
+	}
+};
+
+
+//------------------------------------------------------
+// Parallel stable merge sort.  The two halves of every split run as
+// parallel tasks, and every merge is itself cut into independent pieces:
+// for an output position k, co_rank() binary-searches how many of the
+// first k merged elements come from the left input, so each piece of the
+// output can be merged by a different thread with no coordination.
+//
+// arr and aux swap roles at each level (sort(src, dst) leaves its result
+// in dst), so no level copies its input before merging.  The data starts
+// in arr only: a leaf whose dst is aux moves its elements across first,
+// in parallel with the other leaves, and is then merge_sorted using the
+// matching slice of the other buffer as its scratch, so aux is the only
+// allocation.  Ties always take the left element, so the result
+// is stable exactly like merge_sort.
+//------------------------------------------------------
+template <typename T>
+class parallel_merge_sort {
+public:
+	static const size_t SEQUENTIAL_CUTOFF = 1 << 14;
+	static const size_t MERGE_GRAIN = 1 << 14;
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp(), size_t threads = 0) {
+		work_stealing_pool pool(threads);
+		sort(arr, n, comp, pool);
+	}
+
+	template <typename Comp>
+	static void sort(T* arr, size_t n, const Comp& comp, work_stealing_pool& pool) {
+		if (n < 2) return;
+		std::unique_ptr<T[]> aux(new T[n]);
+		sort(aux.get(), arr, 0, n, true, comp, pool);
+		assert(is_sorted(arr, n, comp));
+	}
+
+	// number of elements of a[0..m) among the first k elements of the stable merge of a and b
+	template <typename Comp>
+	static size_t co_rank(size_t k, const T* a, size_t m, const T* b, size_t n, const Comp& comp) {
+		size_t low = k > n ? k - n : 0;
+		size_t high = std::min(k, m);
+		while (low < high) {
+			size_t i = low + (high - low) / 2;
+			size_t j = k - i;
+			if (j > 0 && !less(b[j - 1], a[i], comp)) { low = i + 1; }   // a[i] merges before b[j-1]
+			else { high = i; }
+		}
+		return low;
+	}
+
+private:
+	// sorts [low, high) into dst; the elements start out in dst if in_dst, else in src,
+	// and src is scratch afterwards
+	template <typename Comp>
+	static void sort(T* src, T* dst, size_t low, size_t high, bool in_dst, const Comp& comp,
+		work_stealing_pool& pool) {
+		if (high - low <= SEQUENTIAL_CUTOFF) {
+			if (!in_dst) { std::move(src + low, src + high, dst + low); }
+			merge_sort<T>::sort(dst + low, high - low, comp, src + low);     // src[low, high) is free now
+			return;
+		}
+		size_t mid = low + (high - low) / 2;
+		task_group group(pool);
+		group.run([=, &comp, &pool] { sort(dst, src, low, mid, !in_dst, comp, pool); });
+		sort(dst, src, mid, high, !in_dst, comp, pool);
+		group.wait();      // rethrows a failed half before its run is merged
+		merge(src + low, mid - low, src + mid, high - mid, dst + low, comp, pool);
+	}
+
+	template <typename Comp>
+	static void merge(T* a, size_t m, T* b, size_t n, T* out, const Comp& comp,
+		work_stealing_pool& pool) {
+		size_t total = m + n;
+		size_t pieces = std::min(total / MERGE_GRAIN + 1, 4 * pool.size());
+
+		// every split point is found before any piece starts moving elements out of a and b
+		std::vector<size_t> ranks(pieces + 1);
+		for (size_t p = 0; p <= pieces; ++p) { ranks[p] = co_rank(total * p / pieces, a, m, b, n, comp); }
+
+		task_group group(pool);
+		for (size_t p = 0; p < pieces; ++p) {
+			group.run([=, &comp, &ranks] {
+				size_t k0 = total * p / pieces, k1 = total * (p + 1) / pieces;
+				size_t i0 = ranks[p], i1 = ranks[p + 1];
+				merge_sequential(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), out + k0, comp);
+			});
+		}
+		group.wait();
+	}
+
+	template <typename Comp>
+	static void merge_sequential(T* a, T* a_end, T* b, T* b_end, T* out, const Comp& comp) {
+		while (a != a_end && b != b_end) {
+			if (less(*b, *a, comp)) { *out++ = std::move(*b++); }
+			else { *out++ = std::move(*a++); }
+		}
+		out = std::move(a, a_end, out);
+		std::move(b, b_end, out);
+	}
+};
+
+//------------------------------------------------------
+// Parallel sample sort (after Sanders & Winkel's super scalar samplesort),
+// for arrays far larger than cores x cache.  The recursive sorts above
+// start with one task at the root and only fan out as they split; here
+// every pass is split across all threads from the start.
+//   - BUCKETS - 1 splitters are picked from a random sample OVERSAMPLING
+//     times larger (std_random indices, sorted with intro_sort)
+//   - an element finds its bucket by descending an implicit binary tree of
+//     the splitters (children of node j at 2j and 2j + 1); each level adds
+//     the comparison result to j instead of branching on it, and BATCH
+//     elements descend in lockstep so their loads overlap
+//   - the input is cut into one block per pool thread.  Pass 1 classifies
+//     each block and counts its buckets; prefix sums over (bucket, block)
+//     give every block its own output range in each bucket; pass 2 moves
+//     each block's elements into aux, so no two threads write one place
+//   - one task per bucket then moves it back into arr and intro_sorts it
+// Equal keys all land in the same bucket, so a key that fills most of
+// the array is sorted by a single thread.
+//------------------------------------------------------
+template <typename T>
+class parallel_sample_sort {
+public:
+	static const size_t SEQUENTIAL_CUTOFF = 1 << 16;
+	static const size_t MAX_BUCKETS = 256;             // bucket ids fit in a byte
+	static const size_t OVERSAMPLING = 32;
+	static const size_t BATCH = 8;
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp(), size_t threads = 0) {
+		work_stealing_pool pool(threads);
+		sort(arr, n, comp, pool);
+	}
+
+	template <typename Comp>
+	static void sort(T* arr, size_t n, const Comp& comp, work_stealing_pool& pool) {
+		if (n < 2 * SEQUENTIAL_CUTOFF) {
+			intro_sort<T>::sort(arr, n, comp);
+			return;
+		}
+		size_t buckets = 2, log_buckets = 1;
+		while (buckets < MAX_BUCKETS && buckets * SEQUENTIAL_CUTOFF < n) { buckets *= 2;  ++log_buckets; }
+		std::vector<T> tree = splitter_tree(arr, n, buckets, comp);
+
+		size_t blocks = pool.size();
+		size_t block_size = (n + blocks - 1) / blocks;
+		std::vector<uint8_t> ids(n);
+		std::vector<size_t> counts(blocks * buckets);       // counts[block * buckets + bucket]
+		{
+			task_group group(pool);
+			for (size_t b = 0; b < blocks; ++b) {
+				group.run([&, b] {
+					size_t low = std::min(n, b * block_size), high = std::min(n, low + block_size);
+					classify(arr, low, high, tree.data(), log_buckets, ids.data(), comp);
+					size_t* count = &counts[b * buckets];
+					for (size_t i = low; i < high; ++i) { ++count[ids[i]]; }
+				});
+			}
+			group.wait();
+		}
+
+		// counts become each block's next output position in each bucket
+		std::vector<size_t> bucket_start(buckets + 1);
+		size_t sum = 0;
+		for (size_t k = 0; k < buckets; ++k) {
+			bucket_start[k] = sum;
+			for (size_t b = 0; b < blocks; ++b) {
+				size_t count = counts[b * buckets + k];
+				counts[b * buckets + k] = sum;
+				sum += count;
+			}
+		}
+		bucket_start[buckets] = n;
+
+		std::unique_ptr<T[]> aux(new T[n]);
+		{
+			task_group group(pool);
+			for (size_t b = 0; b < blocks; ++b) {
+				group.run([&, b] {
+					size_t low = std::min(n, b * block_size), high = std::min(n, low + block_size);
+					size_t* next = &counts[b * buckets];
+					for (size_t i = low; i < high; ++i) { aux[next[ids[i]]++] = std::move(arr[i]); }
+				});
+			}
+			group.wait();
+		}
+		{
+			task_group group(pool);
+			for (size_t k = 0; k < buckets; ++k) {
+				size_t low = bucket_start[k], high = bucket_start[k + 1];
+				if (low == high) { continue; }
+				group.run([=, &aux, &comp] {
+					std::move(aux.get() + low, aux.get() + high, arr + low);
+					intro_sort<T>::sort(arr + low, high - low, comp);
+				});
+			}
+			group.wait();
+		}
+		assert(is_sorted(arr, n, comp));
+	}
+
+private:
+	// tree[1..buckets) holds the splitters breadth-first: node j's left and right
+	// subtrees hold the splitters below and above it
+	template <typename Comp>
+	static std::vector<T> splitter_tree(const T* arr, size_t n, size_t buckets, const Comp& comp) {
+		size_t s = OVERSAMPLING * buckets - 1;
+		std::vector<int> picks(s);
+		std_random<int>::generate_uniform_int(picks.data(), s, 0, INT_MAX);
+		std::vector<T> sample(s);
+		for (size_t i = 0; i < s; ++i) { sample[i] = arr[(uint64_t(picks[i]) * n) >> 31]; }
+		intro_sort<T>::sort(sample.data(), s, comp);
+
+		// splitter r (1 <= r < buckets) is sample[r * OVERSAMPLING - 1]; node j at depth d,
+		// p-th in its level, is splitter (2p + 1) * buckets / 2^(d + 1)
+		std::vector<T> tree(buckets);
+		for (size_t j = 1, depth = 0; j < buckets; ++j) {
+			if (j == (size_t(2) << depth)) { ++depth; }
+			size_t p = j - (size_t(1) << depth);
+			size_t r = (2 * p + 1) * (buckets >> (depth + 1));
+			tree[j] = sample[r * OVERSAMPLING - 1];
+		}
+		return tree;
+	}
+
+	// ids[i] = the bucket of arr[i]: the number of splitters <= arr[i]
+	template <typename Comp>
+	static void classify(const T* arr, size_t low, size_t high, const T* tree, size_t log_buckets,
+		uint8_t* ids, const Comp& comp) {
+		size_t buckets = size_t(1) << log_buckets;
+		size_t i = low;
+		for (; i + BATCH <= high; i += BATCH) {
+			size_t j[BATCH];
+			for (size_t b = 0; b < BATCH; ++b) { j[b] = 1; }
+			for (size_t level = 0; level < log_buckets; ++level) {
+				for (size_t b = 0; b < BATCH; ++b) { j[b] = 2 * j[b] + !less(arr[i + b], tree[j[b]], comp); }
+			}
+			for (size_t b = 0; b < BATCH; ++b) { ids[i + b] = uint8_t(j[b] - buckets); }
+		}
+		for (; i < high; ++i) {
+			size_t j = 1;
+			for (size_t level = 0; level < log_buckets; ++level) { j = 2 * j + !less(arr[i], tree[j], comp); }
+			ids[i] = uint8_t(j - buckets);
+		}
+	}
+};
+
+
+#endif /* Parallel_Sort_h */
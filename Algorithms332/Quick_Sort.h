@@ -1,29 +1,60 @@
+#ifndef Quick_Sort_h
+#define Quick_Sort_h
+
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Utils.h"
 #include "Random.h"
+#include "Insertion_Sort.h"
+#include "Heap_Sort.h"
+#include "Sorting_Network.h"
+
+// Types for which intro_sort uses quick_sort<T>::block_partition by default.
+// Block partitioning only pays off when a comparison is a cheap, inlinable
+// instruction, so it is on for primitive keys; specialize to opt a type in or out.
+template <typename T>
+struct use_block_partition : std::is_arithmetic<T> { };
 
 template <typename T>
 class quick_sort
 {
 public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>())
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp())
 	{
-		std_random::shuffle(arr, n);
+		std_random<T>::shuffle(arr, n);
+		count_swaps(comp, n);
 		sort(arr, 0, int(n - 1), comp);
-		assert(is_sorted(arr, n));
+		assert(is_sorted(arr, n, comp));
 	}
 
 private:
-	static void sort(T* arr, int low, int high, const comparator<T>& comp)
+	template <typename Comp>
+	static void sort(T* arr, int low, int high, const Comp& comp)
 	{
+		recursion_depth<Comp> depth(comp);
+		if constexpr (use_sorting_network<T, Comp>::value) {
+			if (high - low < int(sorting_network<T>::MAX)) {
+				if (low < high) { sorting_network<T>::sort_unchecked(arr + low, size_t(high - low + 1)); }
+				return;
+			}
+		}
 		if (high <= low) return;
 		int j = partition(arr, low, high, comp); // Partition (see page 291).
 		sort(arr, low, j - 1, comp); // Sort left part a[lo .. j-1].
 		sort(arr, j + 1, high, comp); // Sort right part a[j+1 .. hi].
 	}
 
-	static int partition(T* arr, int low, int high, const comparator<T>& comp)
+public:
+	// partitions around v = arr[low]; callers that pick their own pivot swap it to arr[low] first
+	template <typename Comp>
+	static int partition(T* arr, int low, int high, const Comp& comp)
 	{ // Partition into a[lo..i-1], a[i], a[i+1..hi].
 		int i = low, j = high + 1; // left and right scan indices
-		T v = arr[low]; // partitioning item
+		const T& v = arr[low]; // partitioning item (stays at arr[low] until the end)
 
 		while (true)
 		{ // Scan right, scan left, check for scan complete, and exchange.
@@ -45,73 +76,589 @@ private:
 				break;
 			}
 
-			exch(arr, i, j);
+			exch(arr, i, j, comp);
 		}
-		exch(arr, low, j); // Put v = a[j] into position
+		exch(arr, low, j, comp); // Put v = a[j] into position
 		return j; // with a[lo..j-1] <= a[j] <= a[j+1..hi].
 	}
 
-	static void exch(T* arr, int i, int j)
+	// Same contract as partition(), in the style of BlockQuicksort (Edelkamp & Weiss).
+	// Each side scans a block of BLOCK elements and records, without branching,
+	// the offsets of the elements that belong on the other side; the two offset
+	// buffers are then swapped pairwise in bulk.  As in partition(), both sides
+	// stop on keys equal to v, so runs of duplicates still split evenly.
+	// The last <= 2 * BLOCK elements are finished by the scalar scan.
+	static const int BLOCK = 64;
+
+	template <typename Comp>
+	static int block_partition(T* arr, int low, int high, const Comp& comp)
+	{
+		bool already_partitioned;
+		return block_partition(arr, low, high, already_partitioned, comp);
+	}
+
+	// also reports whether any element other than v had to move
+	template <typename Comp>
+	static int block_partition(T* arr, int low, int high, bool& already_partitioned, const Comp& comp)
+	{
+		already_partitioned = true;
+		const T& v = arr[low];           // stays at arr[low] until the end
+		int l = low + 1, r = high;       // a[lo+1..l-1] <= v <= a[r+1..hi]
+		unsigned char offsets_l[BLOCK], offsets_r[BLOCK];
+		int num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+		while (r - l + 1 > 2 * BLOCK)
+		{
+			if (num_l == 0)
+			{
+				start_l = 0;
+				for (int i = 0; i < BLOCK; ++i)
+				{
+					offsets_l[num_l] = (unsigned char)i;
+					num_l += !less(arr[l + i], v, comp);
+				}
+			}
+			if (num_r == 0)
+			{
+				start_r = 0;
+				for (int i = 0; i < BLOCK; ++i)
+				{
+					offsets_r[num_r] = (unsigned char)i;
+					num_r += !less(v, arr[r - i], comp);
+				}
+			}
+
+			int num = num_l < num_r ? num_l : num_r;
+			if (num > 0) { already_partitioned = false; }
+			for (int k = 0; k < num; ++k)
+			{
+				exch(arr, l + offsets_l[start_l + k], r - offsets_r[start_r + k], comp);
+			}
+			num_l -= num;  start_l += num;
+			num_r -= num;  start_r += num;
+			if (num_l == 0) { l += BLOCK; }
+			if (num_r == 0) { r -= BLOCK; }
+		}
+
+		// a half-consumed block is simply rescanned here
+		while (true)
+		{
+			while (l <= r && less(arr[l], v, comp)) { ++l; }
+			while (l <= r && less(v, arr[r], comp)) { --r; }
+			if (l >= r) { break; }
+			already_partitioned = false;
+			exch(arr, l++, r--, comp);
+		}
+		exch(arr, low, r, comp);
+		return r;
+	}
+
+private:
+	template <typename Comp>
+	static void exch(T* arr, int i, int j, const Comp& comp)
+	{
+		count_swaps(comp, 1);
+		T temp = std::move(arr[i]);
+		arr[i] = std::move(arr[j]);
+		arr[j] = std::move(temp);
+	}
+};
+
+//------------------------------------------------------
+// Introsort: quick_sort without the up-front shuffle.
+//   - pivot is the median of 3 (or Tukey's ninther on larger subarrays),
+//     moved to arr[low] and handed to quick_sort<T>::partition, or to
+//     quick_sort<T>::block_partition when Block is set (the default for
+//     types with use_block_partition<T>, i.e., primitive keys)
+//   - subarrays of INSERTION_CUTOFF or fewer go to insertion_sort (or, up
+//     to sorting_network<T>::MAX, a sorting network, for primitive keys)
+//   - once the recursion is 2 lg n deep the subarray is heapsorted
+//     (heap_sort<T>), so the worst case stays O(n lg n)
+//   - only the smaller side is recursed on; the larger side loops,
+//     so the stack never exceeds lg n frames
+//------------------------------------------------------
+template <typename T, bool Block = use_block_partition<T>::value>
+class intro_sort
+{
+public:
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp())
+	{
+		if (n < 2) return;
+		sort(arr, 0, int(n - 1), 2 * floor_lg(n), comp);
+		assert(is_sorted(arr, n, comp));
+	}
+
+	static const int INSERTION_CUTOFF = 16;
+	static const int NINTHER_CUTOFF = 128;
+
+private:
+	template <typename Comp>
+	static void sort(T* arr, int low, int high, int depth_limit, const Comp& comp)
+	{
+		recursion_depth<Comp> depth(comp);
+		const int leaf = use_sorting_network<T, Comp>::value ? int(sorting_network<T>::MAX) : INSERTION_CUTOFF;
+		while (high - low + 1 > leaf)
+		{
+			if (depth_limit-- == 0)
+			{
+				heap_sort(arr, low, high, comp);
+				return;
+			}
+
+			exchange(arr, low, choose_pivot(arr, low, high, comp), comp);
+			int j = Block ? quick_sort<T>::block_partition(arr, low, high, comp)
+				: quick_sort<T>::partition(arr, low, high, comp);
+
+			if (j - low < high - j)
+			{
+				sort(arr, low, j - 1, depth_limit, comp);
+				low = j + 1;
+			}
+			else
+			{
+				sort(arr, j + 1, high, depth_limit, comp);
+				high = j - 1;
+			}
+		}
+		if (low >= high) { return; }
+		if constexpr (use_sorting_network<T, Comp>::value) { sorting_network<T>::sort_unchecked(arr + low, size_t(high - low + 1)); }
+		else { insertion_sort<T>::sort(arr, size_t(low), size_t(high), comp); }
+	}
+
+public:
+	// index of the median of 3 (or ninther) of arr[low..high]
+	template <typename Comp>
+	static int choose_pivot(T* arr, int low, int high, const Comp& comp)
+	{
+		int n = high - low + 1;
+		int mid = low + n / 2;
+		if (n <= NINTHER_CUTOFF) { return median_of_3(arr, low, mid, high, comp); }
+
+		int eps = n / 8;
+		int a = median_of_3(arr, low, low + eps, low + 2 * eps, comp);
+		int b = median_of_3(arr, mid - eps, mid, mid + eps, comp);
+		int c = median_of_3(arr, high - 2 * eps, high - eps, high, comp);
+		return median_of_3(arr, a, b, c, comp);
+	}
+
+	// heapsort of arr[low..high], used once the depth limit is hit
+	template <typename Comp>
+	static void heap_sort(T* arr, int low, int high, const Comp& comp)
+	{
+		::heap_sort<T>::sort(arr + low, size_t(high - low + 1), comp);
+	}
+
+	static int floor_lg(size_t n)
+	{
+		int lg = 0;
+		while (n >>= 1) { ++lg; }
+		return lg;
+	}
+
+private:
+	template <typename Comp>
+	static int median_of_3(T* arr, int i, int j, int k, const Comp& comp)
 	{
-		T temp = arr[i];
-		arr[i] = arr[j];
-		arr[j] = temp;
+		return less(arr[i], arr[j], comp)
+			? (less(arr[j], arr[k], comp) ? j : less(arr[i], arr[k], comp) ? k : i)
+			: (less(arr[k], arr[j], comp) ? j : less(arr[k], arr[i], comp) ? k : i);
 	}
 };
 
+//------------------------------------------------------
+// 3-way quicksort for input with many equal keys, with Bentley & McIlroy's
+// partition ("Engineering a Sort Function", 1993):
+//   - the two scans of quick_sort<T>::partition, plus: a key equal to the
+//     pivot is swapped out to arr[low..p] or arr[q..high] when a scan stops
+//     on it, and the two blocks of equal keys are swapped into the middle
+//     once, at the end.  A key that is not equal to the pivot costs at most
+//     one swap, and input with no duplicates costs what quick_sort does.
+//   - pivot is intro_sort's median of 3 (or ninther), no shuffle; once the
+//     recursion is 2 lg n deep the subarray is heapsorted
+//   - subarrays of INSERTION_CUTOFF or fewer go to insertion_sort (or a
+//     sorting network, for primitive keys)
+//   - only the smaller side is recursed on; the larger side loops
+//------------------------------------------------------
 template <typename T>
 class quick_sort_3way {
 public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>())
+	static const int INSERTION_CUTOFF = 16;
+
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp())
 	{
-		std_random<T>::shuffle(arr, n);
-		sort(arr, 0, int(n - 1), comp);
-		assert(is_sorted(arr, n));
+		if (n < 2) return;
+		sort(arr, 0, int(n - 1), 2 * intro_sort<T>::floor_lg(n), comp);
+		assert(is_sorted(arr, n, comp));
 	}
 
-private:
-	static void sort(T* arr, int low, int high, const comparator<T>& comp)
-	{ // See page 289 for public sort() that calls this method.
-		if (high <= low) return;
-		int lt = low, i = low, gt = high;
-		T* v = &arr[low];
+	// 3-way partition around v = arr[low]; on return a[lo..lt-1] < v = a[lt..gt] < a[gt+1..hi]
+	template <typename Comp>
+	static void partition(T* arr, int low, int high, int& lt, int& gt, const Comp& comp)
+	{
+		int i = low, j = high + 1;
+		int p = low, q = high + 1;       // arr[low..p] and arr[q..high] are equal to v
+		const T& v = arr[low];           // stays at arr[low] until the scans are done
 
-		while (i <= gt)
+		while (true)
 		{
-			if (less(arr[i], *v, comp))
+			while (less(arr[++i], v, comp)) { if (i == high) break; }
+			while (less(v, arr[--j], comp)) { if (j == low) break; }
+
+			if (i == j && !less(arr[i], v, comp)) { exch(arr, ++p, i, comp); }  // scans met on a copy of v
+			if (i >= j) break;
+
+			exch(arr, i, j, comp);
+			if (!less(arr[i], v, comp)) { exch(arr, ++p, i, comp); }   // arr[i] <= v: equal unless less
+			if (!less(v, arr[j], comp)) { exch(arr, --q, j, comp); }   // arr[j] >= v: equal unless greater
+		}
+
+		i = j + 1;
+		for (int k = low; k <= p; ++k) { exch(arr, k, j--, comp); }
+		for (int k = high; k >= q; --k) { exch(arr, k, i++, comp); }
+		lt = j + 1;
+		gt = i - 1;
+	}
+
+private:
+	template <typename Comp>
+	static void sort(T* arr, int low, int high, int depth_limit, const Comp& comp)
+	{
+		recursion_depth<Comp> depth(comp);
+		while (true)
+		{
+			if constexpr (use_sorting_network<T, Comp>::value) {
+				if (high - low < int(sorting_network<T>::MAX)) {
+					if (low < high) { sorting_network<T>::sort_unchecked(arr + low, size_t(high - low + 1)); }
+					return;
+				}
+			}
+			if (high - low + 1 <= INSERTION_CUTOFF)
 			{
-				bool changeV = false;
-				if (*v == arr[lt])
-				{
-					changeV = true;
+				if (low < high) { insertion_sort<T>::sort(arr, size_t(low), size_t(high), comp); }
+				return;
+			}
+			if (depth_limit-- == 0)
+			{
+				intro_sort<T>::heap_sort(arr, low, high, comp);
+				return;
+			}
+
+			exchange(arr, low, intro_sort<T>::choose_pivot(arr, low, high, comp), comp);
+			int lt, gt;
+			partition(arr, low, high, lt, gt, comp);
+
+			if (lt - low < high - gt)
+			{
+				sort(arr, low, lt - 1, depth_limit, comp);
+				low = gt + 1;
+			}
+			else
+			{
+				sort(arr, gt + 1, high, depth_limit, comp);
+				high = lt - 1;
+			}
+		}
+	}
+
+	template <typename Comp>
+	static void exch(T* arr, int i, int j, const Comp& comp)
+	{
+		count_swaps(comp, 1);
+		T temp = std::move(arr[i]);
+		arr[i] = std::move(arr[j]);
+		arr[j] = std::move(temp);
+	}
+};
+
+//------------------------------------------------------
+// Pattern-defeating quicksort (after Orson Peters' pdqsort), for input that
+// is often already sorted, reversed, or sorted with a few records appended.
+//   - an input that is entirely ascending returns after one scan, one
+//     that is strictly descending is reversed in place, and a sorted input
+//     with a short unsorted tail appended only sorts the tail and merges it
+//   - median of 3 / ninther pivots, no shuffle; primitive keys partition
+//     with quick_sort<T>::block_partition, others with partition_right()
+//   - a partition that moved nothing is assumed to be nearly sorted: both
+//     sides get an insertion sort that gives up after PARTIAL_INSERTION_LIMIT
+//     moves, so presorted subarrays finish in linear time
+//   - a pivot equal to the element just left of the subarray means that
+//     subarray is full of copies of it: partition_left() puts the copies on
+//     the left and they are never touched again
+//   - a split worse than 1:7 shuffles a few elements around to break up
+//     adversarial patterns, and after lg n such splits the subarray is
+//     handed to heapsort
+//   - subarrays below INSERTION_CUTOFF go to insertion sort (or, up to
+//     sorting_network<T>::MAX, a sorting network, for primitive keys)
+// Indices here are half-open: a subarray is arr[begin..end).
+//------------------------------------------------------
+template <typename T, bool Block = use_block_partition<T>::value>
+class pdq_sort
+{
+public:
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp())
+	{
+		if (n < 2) return;
+		if (!presorted(arr, int(n), comp))
+		{
+			sort(arr, 0, int(n), intro_sort<T>::floor_lg(n), true, comp);
+		}
+		assert(is_sorted(arr, n, comp));
+	}
+
+	static const int INSERTION_CUTOFF = 24;
+	static const int NINTHER_CUTOFF = 128;
+	static const int PARTIAL_INSERTION_LIMIT = 8;
+
+private:
+	// Handles the whole-array patterns and returns true if arr is now sorted:
+	// ascending (nothing to do), strictly descending (reversed), or an
+	// ascending run followed by a tail of at most 1/TAIL_FRACTION of the
+	// input (the tail is sorted on its own and merged in from the back,
+	// using a buffer the size of the tail).
+	static const int TAIL_FRACTION = 8;
+
+	template <typename Comp>
+	static bool presorted(T* arr, int n, const Comp& comp)
+	{
+		int run = 1;
+		if (less(arr[1], arr[0], comp))
+		{
+			while (run < n && less(arr[run], arr[run - 1], comp)) { ++run; }
+			if (run < n) { return false; }
+			for (int lo = 0, hi = n - 1; lo < hi; ++lo, --hi) { exchange(arr, lo, hi, comp); }
+			return true;
+		}
+
+		while (run < n && !less(arr[run], arr[run - 1], comp)) { ++run; }
+		int tail = n - run;
+		if (tail == 0) { return true; }
+		if (tail > n / TAIL_FRACTION) { return false; }
+
+		sort(arr + run, size_t(tail), comp);
+		std::vector<T> aux(std::make_move_iterator(arr + run), std::make_move_iterator(arr + n));
+		count_scratch(comp, tail * sizeof(T));
+		int i = run - 1, j = tail - 1, k = n - 1;
+		while (j >= 0)
+		{
+			if (i >= 0 && less(aux[j], arr[i], comp)) { arr[k--] = std::move(arr[i--]); }
+			else { arr[k--] = std::move(aux[j--]); }
+		}
+		count_moves(comp, tail + (n - 1 - k));
+		return true;
+	}
+
+	template <typename Comp>
+	static void sort(T* arr, int begin, int end, int bad_allowed, bool leftmost, const Comp& comp)
+	{
+		recursion_depth<Comp> depth(comp);
+		while (true)
+		{
+			int size = end - begin;
+			if constexpr (use_sorting_network<T, Comp>::value) {
+				if (size <= int(sorting_network<T>::MAX)) {
+					if (size >= 2) { sorting_network<T>::sort_unchecked(arr + begin, size_t(size)); }
+					return;
 				}
+			}
+			if (size < INSERTION_CUTOFF)
+			{
+				if (size < 2) { return; }
+				if (leftmost) { insertion_sort<T>::sort(arr, size_t(begin), size_t(end - 1), comp); }
+				else { unguarded_insertion_sort(arr, begin, end, comp); }
+				return;
+			}
 
-				exch(arr, lt++, i++);
+			int mid = begin + size / 2;
+			if (size > NINTHER_CUTOFF)
+			{
+				sort3(arr, begin, mid, end - 1, comp);
+				sort3(arr, begin + 1, mid - 1, end - 2, comp);
+				sort3(arr, begin + 2, mid + 1, end - 3, comp);
+				sort3(arr, mid - 1, mid, mid + 1, comp);
+				exchange(arr, begin, mid, comp);
+			}
+			else { sort3(arr, mid, begin, end - 1, comp); }
 
-				if (changeV)
+			// arr[begin - 1] <= everything here, so if it is not less than the
+			// pivot every key equal to the pivot can be split off and finished
+			if (!leftmost && !less(arr[begin - 1], arr[begin], comp))
+			{
+				begin = partition_left(arr, begin, end, comp) + 1;
+				continue;
+			}
+
+			bool already_partitioned;
+			int p = Block ? quick_sort<T>::block_partition(arr, begin, end - 1, already_partitioned, comp)
+				: partition_right(arr, begin, end, already_partitioned, comp);
+			int l_size = p - begin, r_size = end - (p + 1);
+
+			if (l_size < size / 8 || r_size < size / 8)
+			{
+				if (--bad_allowed == 0)
 				{
-					v = &arr[i - 1];
+					intro_sort<T>::heap_sort(arr, begin, end - 1, comp);
+					return;
 				}
-			} 
-			else if(less(*v, arr[i], comp))
+				if (l_size >= INSERTION_CUTOFF) { break_patterns(arr, begin, p, comp); }
+				if (r_size >= INSERTION_CUTOFF) { break_patterns(arr, p + 1, end, comp); }
+			}
+			else if (already_partitioned
+				&& partial_insertion_sort(arr, begin, p, comp)
+				&& partial_insertion_sort(arr, p + 1, end, comp))
 			{
-				exch(arr, i, gt--);
+				return;
 			}
-			else 
+
+			// recurse on the smaller side, loop on the larger
+			if (l_size < r_size)
+			{
+				sort(arr, begin, p, bad_allowed, leftmost, comp);
+				begin = p + 1;
+				leftmost = false;
+			}
+			else
 			{
-				i++;
+				sort(arr, p + 1, end, bad_allowed, false, comp);
+				end = p;
 			}
+		}
+	}
+
+	// partitions around v = arr[begin] into [< v] v [>= v] and returns v's final index;
+	// already_partitioned is set when no element had to move
+	template <typename Comp>
+	static int partition_right(T* arr, int begin, int end, bool& already_partitioned, const Comp& comp)
+	{
+		T v = std::move(arr[begin]);     // the scans below never read arr[begin]
+		int first = begin, last = end;
+
+		// sort3 left an element >= v at the end, so this scan is guarded
+		while (less(arr[++first], v, comp)) { }
+
+		// if that scan moved at all it passed an element < v, which guards this one
+		if (first - 1 == begin) { while (first < last && !less(arr[--last], v, comp)) { } }
+		else { while (!less(arr[--last], v, comp)) { } }
 
-		} // Now a[lo..lt-1] < v = a[lt..gt] < a[gt+1..hi].
+		already_partitioned = first >= last;
+		while (first < last)
+		{
+			exchange(arr, first, last, comp);
+			while (less(arr[++first], v, comp)) { }
+			while (!less(arr[--last], v, comp)) { }
+		}
 
-		sort(arr, low, lt - 1, comp);
-		sort(arr, gt + 1, high, comp);
+		int p = first - 1;
+		arr[begin] = std::move(arr[p]);
+		arr[p] = std::move(v);
+		count_moves(comp, 3);
+		return p;
 	}
 
-	static void exch(T* arr, int i, int j)
+	// partitions around v = arr[begin] into [<= v] v [> v]; used when v equals arr[begin - 1]
+	template <typename Comp>
+	static int partition_left(T* arr, int begin, int end, const Comp& comp)
 	{
-		T temp = arr[i];
-		arr[i] = arr[j];
-		arr[j] = temp;
+		T v = std::move(arr[begin]);
+		int first = begin, last = end;
+
+		while (less(v, arr[--last], comp)) { }
+
+		if (last + 1 == end) { while (first < last && !less(v, arr[++first], comp)) { } }
+		else { while (!less(v, arr[++first], comp)) { } }
+
+		while (first < last)
+		{
+			exchange(arr, first, last, comp);
+			while (less(v, arr[--last], comp)) { }
+			while (!less(v, arr[++first], comp)) { }
+		}
+
+		arr[begin] = std::move(arr[last]);
+		arr[last] = std::move(v);
+		count_moves(comp, 3);
+		return last;
 	}
-};
\ No newline at end of file
+
+	// insertion sort of arr[begin..end) that gives up once PARTIAL_INSERTION_LIMIT
+	// elements have been moved; returns whether the subarray is now sorted
+	template <typename Comp>
+	static bool partial_insertion_sort(T* arr, int begin, int end, const Comp& comp)
+	{
+		int moves = 0;
+		for (int i = begin + 1; i < end; ++i)
+		{
+			if (!less(arr[i], arr[i - 1], comp)) { continue; }
+
+			T v = std::move(arr[i]);
+			int j = i;
+			do
+			{
+				arr[j] = std::move(arr[j - 1]);
+				--j;
+			} while (j > begin && less(v, arr[j - 1], comp));
+			arr[j] = std::move(v);
+			count_moves(comp, i - j + 2);
+
+			moves += i - j;
+			if (moves > PARTIAL_INSERTION_LIMIT) { return false; }
+		}
+		return true;
+	}
+
+	// arr[begin - 1] is <= every element here, so the inner loop needs no bound check
+	template <typename Comp>
+	static void unguarded_insertion_sort(T* arr, int begin, int end, const Comp& comp)
+	{
+		for (int i = begin + 1; i < end; ++i)
+		{
+			if (!less(arr[i], arr[i - 1], comp)) { continue; }
+
+			T v = std::move(arr[i]);
+			int j = i;
+			do
+			{
+				arr[j] = std::move(arr[j - 1]);
+				--j;
+			} while (less(v, arr[j - 1], comp));
+			arr[j] = std::move(v);
+			count_moves(comp, i - j + 2);
+		}
+	}
+
+	// swaps a few elements a quarter of the way in from each end of arr[begin..end)
+	template <typename Comp>
+	static void break_patterns(T* arr, int begin, int end, const Comp& comp)
+	{
+		int size = end - begin;
+		int q = size / 4;
+		exchange(arr, begin, begin + q, comp);
+		exchange(arr, end - 1, end - q, comp);
+		if (size > NINTHER_CUTOFF)
+		{
+			exchange(arr, begin + 1, begin + q + 1, comp);
+			exchange(arr, begin + 2, begin + q + 2, comp);
+			exchange(arr, end - 2, end - q - 1, comp);
+			exchange(arr, end - 3, end - q - 2, comp);
+		}
+	}
+
+	template <typename Comp>
+	static void sort2(T* arr, int i, int j, const Comp& comp)
+	{
+		if (less(arr[j], arr[i], comp)) { exchange(arr, i, j, comp); }
+	}
+
+	// leaves arr[i] <= arr[j] <= arr[k]
+	template <typename Comp>
+	static void sort3(T* arr, int i, int j, int k, const Comp& comp)
+	{
+		sort2(arr, i, j, comp);
+		sort2(arr, j, k, comp);
+		sort2(arr, i, j, comp);
+	}
+};
+
+#endif /* Quick_Sort_h */
\ No newline at end of file
@@ -0,0 +1,136 @@
+//
+//  Radix_Sort.h
+//  Algorithms332
+//
+//  LSD radix sort for fixed-width keys: 8/16/32/64-bit integers, float and
+//  double.  Not comparison based, so it only sorts ascending by the natural
+//  order of the key, but it takes a fixed number of linear passes.
+//
+
+#ifndef Radix_Sort_h
+#define Radix_Sort_h
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "Utils.h"
+
+
+//------------------------------------------------------
+// Maps a key to an unsigned integer of the same width whose unsigned order
+// is the key's order: signed integers get their sign bit flipped, floats
+// get every bit flipped when negative and only the sign bit otherwise.
+// (-0.0 sorts just before +0.0; NaNs go to the ends.)
+//------------------------------------------------------
+template <typename Key, typename Enable = void>
+struct radix_key;
+
+template <typename Key>
+struct radix_key<Key, typename std::enable_if<std::is_integral<Key>::value>::type> {
+	typedef typename std::make_unsigned<Key>::type bits_type;
+	static bits_type bits(Key k) {
+		bits_type u = bits_type(k);
+		if (std::is_signed<Key>::value) { u ^= bits_type(bits_type(1) << (8 * sizeof(Key) - 1)); }
+		return u;
+	}
+};
+
+template <typename Key>
+struct radix_key<Key, typename std::enable_if<std::is_floating_point<Key>::value>::type> {
+	typedef typename std::conditional<sizeof(Key) == 4, uint32_t, uint64_t>::type bits_type;
+	static bits_type bits(Key k) {
+		static_assert(sizeof(Key) == sizeof(bits_type), "radix_sort supports float and double");
+		bits_type u;
+		std::memcpy(&u, &k, sizeof(u));
+		const bits_type sign = bits_type(1) << (8 * sizeof(Key) - 1);
+		return (u & sign) ? ~u : (u | sign);
+	}
+};
+
+// true for the keys radix_key can map: integers other than bool, float, and double
+template <typename Key>
+struct has_radix_key : std::integral_constant<bool,
+	(std::is_integral<Key>::value && !std::is_same<Key, bool>::value)
+	|| std::is_same<Key, float>::value || std::is_same<Key, double>::value> { };
+
+
+//------------------------------------------------------
+// LSD radix sort on RADIX_BITS-bit digits.  One pass over the input builds
+// the histograms of every digit at once; a digit whose histogram puts all n
+// keys in one bucket (e.g. the high digits of small numbers) is skipped.
+// Each remaining digit is one stable scatter between arr and a scratch
+// array of n elements.
+//
+//   radix_sort<int>::sort(arr, n);
+//   radix_sort<student>::sort(arr, n, [](const student& s) { return s.id; });
+//------------------------------------------------------
+template <typename T>
+class radix_sort {
+public:
+	static const int RADIX_BITS = 11;
+	static const size_t RADIX = size_t(1) << RADIX_BITS;
+
+	static void sort(T* arr, size_t n) {
+		sort(arr, n, [](const T& v) { return v; });
+	}
+
+	// sorts records by the integer or floating-point key that key_of returns
+	template <typename KeyOf>
+	static void sort(T* arr, size_t n, const KeyOf& key_of) {
+		typedef typename std::decay<decltype(key_of(*arr))>::type key_type;
+		typedef typename radix_key<key_type>::bits_type bits_type;
+		const int passes = int((8 * sizeof(bits_type) + RADIX_BITS - 1) / RADIX_BITS);
+
+		if (n < 2) { return; }
+
+		size_t* counts = new size_t[passes * RADIX]();
+		for (size_t i = 0; i < n; ++i) {
+			bits_type b = radix_key<key_type>::bits(key_of(arr[i]));
+			for (int p = 0; p < passes; ++p) { ++counts[p * RADIX + digit(b, p)]; }
+		}
+
+		T* aux = new T[n];
+		T* src = arr;
+		T* dst = aux;
+		for (int p = 0; p < passes; ++p) {
+			size_t* count = counts + p * RADIX;
+			if (trivial_pass(count, n)) { continue; }
+
+			size_t sum = 0;                     // counts -> starting offsets
+			for (size_t d = 0; d < RADIX; ++d) {
+				size_t c = count[d];
+				count[d] = sum;
+				sum += c;
+			}
+			for (size_t i = 0; i < n; ++i) {
+				dst[count[digit(radix_key<key_type>::bits(key_of(src[i])), p)]++] = std::move(src[i]);
+			}
+			std::swap(src, dst);
+		}
+		if (src != arr) {
+			for (size_t i = 0; i < n; ++i) { arr[i] = std::move(src[i]); }
+		}
+		delete[] aux;
+		delete[] counts;
+
+		assert(is_sorted(arr, n, [&](const T& v, const T& w) {
+			return radix_key<key_type>::bits(key_of(v)) < radix_key<key_type>::bits(key_of(w)); }));
+	}
+
+private:
+	template <typename Bits>
+	static size_t digit(Bits b, int pass) {
+		return size_t(b >> (pass * RADIX_BITS)) & (RADIX - 1);
+	}
+
+	static bool trivial_pass(const size_t* count, size_t n) {
+		for (size_t d = 0; d < RADIX; ++d) {
+			if (count[d] != 0) { return count[d] == n; }
+		}
+		return true;
+	}
+};
+
+#endif /* Radix_Sort_h */
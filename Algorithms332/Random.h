@@ -32,9 +32,7 @@ public:
 		for (int i = 0; i < n; ++i) {
 			uniform_int distro(i, (int)n - 1);
 			size_t r = distro(gen);
-			T swap = arr[r];
-			arr[r] = arr[i];
-			arr[i] = swap;
+			exchange(arr, i, r);
 		}
 	}
 
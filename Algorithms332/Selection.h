@@ -0,0 +1,158 @@
+//
+//  Selection.h
+//  Algorithms332
+//
+//  Order statistics without a full sort: the k-th smallest element, the k
+//  smallest in order, and the top k of a stream.  The median of n items
+//  costs O(n) compares instead of O(n lg n), and the top 100 of 50M items
+//  costs about 50M compares and a 100-element heap instead of a 50M sort.
+//
+//    int median = quick_select<int>::select_kth(arr, n, n / 2);
+//    quick_select<int>::partial_sort(arr, n, 100);            // arr[0..100) sorted
+//    std::vector<std::string> top = quick_select<std::string>::top_k(
+//        std::istream_iterator<std::string>(std::cin), std::istream_iterator<std::string>(),
+//        100, rev_comparator<std::string>());                 // the 100 largest words
+//
+
+#ifndef Selection_h
+#define Selection_h
+
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <utility>
+#include <vector>
+#include "Utils.h"
+#include "Insertion_Sort.h"
+#include "Quick_Sort.h"
+#include "Heap_Sort.h"
+
+
+//------------------------------------------------------
+// All orders are by comp, smallest first, like the sorts; pass
+// rev_comparator<T>() to select from the largest end instead.
+//   select_kth    introselect: quick_sort<T>::partition around
+//                 intro_sort's median-of-3 / ninther pivots, narrowing to
+//                 the side that holds k; heapsorts what is left if the
+//                 partitions go 2 lg n deep, so the worst case stays
+//                 O(n lg n).  Expected ~3n compares.
+//   floyd_rivest  Floyd & Rivest's SELECT: recursively selects from a
+//                 sample first, so the two pivots it partitions around
+//                 bracket k tightly; n + min(k, n - k) + o(n) expected
+//                 compares, the fastest choice for large n
+//   partial_sort  the k smallest in sorted order in arr[0..k), via a
+//                 k-element max-heap (heap_sort) that the rest of arr is
+//                 streamed past: O(n lg k), and O(n) when most elements
+//                 lose to the heap's top
+//   top_k         the same heap over an input iterator range (a file, a
+//                 generator, ...); stores only k elements
+// select_kth and floyd_rivest leave arr[0..k) <= arr[k] <= arr(k..n) and
+// return arr[k].
+//------------------------------------------------------
+template <typename T>
+class quick_select {
+public:
+	static const int INSERTION_CUTOFF = 16;
+	static const long FLOYD_RIVEST_CUTOFF = 600;
+
+	template <typename Comp = fwd_comparator<T>>
+	static T& select_kth(T* arr, size_t n, size_t k, const Comp& comp = Comp()) {
+		assert(k < n && n <= size_t(INT_MAX));
+		int low = 0, high = int(n - 1), target = int(k);
+		int depth_limit = 2 * intro_sort<T>::floor_lg(n);
+
+		while (high - low > INSERTION_CUTOFF) {
+			if (depth_limit-- == 0) {
+				heap_sort<T>::sort(arr + low, size_t(high - low + 1), comp);
+				return arr[k];
+			}
+			exchange(arr, low, intro_sort<T>::choose_pivot(arr, low, high, comp));
+			int j = quick_sort<T>::partition(arr, low, high, comp);
+			if (j == target) { return arr[k]; }
+			if (j < target) { low = j + 1; }
+			else { high = j - 1; }
+		}
+		insertion_sort<T>::sort(arr, size_t(low), size_t(high), comp);
+		return arr[k];
+	}
+
+	template <typename Comp = fwd_comparator<T>>
+	static T& floyd_rivest(T* arr, size_t n, size_t k, const Comp& comp = Comp()) {
+		assert(k < n);
+		floyd_rivest(arr, 0, long(n - 1), long(k), comp);
+		return arr[k];
+	}
+
+	template <typename Comp = fwd_comparator<T>>
+	static void partial_sort(T* arr, size_t n, size_t k, const Comp& comp = Comp()) {
+		if (k > n) { k = n; }
+		if (k == 0) { return; }
+		heap_sort<T>::make_heap(arr, k, comp);
+		for (size_t i = k; i < n; ++i) {
+			if (less(arr[i], arr[0], comp)) {                   // beats the largest kept so far
+				T v = std::move(arr[i]);
+				arr[i] = std::move(arr[0]);
+				heap_sort<T>::replace_top(arr, k, std::move(v), comp);
+			}
+		}
+		heap_sort<T>::sort_heap(arr, k, comp);
+		assert(is_sorted(arr, k, comp));
+	}
+
+	template <typename InputIt, typename Comp = fwd_comparator<T>>
+	static std::vector<T> top_k(InputIt first, InputIt last, size_t k, const Comp& comp = Comp()) {
+		std::vector<T> heap;
+		if (k == 0) { return heap; }
+		heap.reserve(k);
+		for (; first != last && heap.size() < k; ++first) { heap.push_back(*first); }
+		heap_sort<T>::make_heap(heap.data(), heap.size(), comp);
+
+		for (; first != last; ++first) {
+			const T& v = *first;
+			if (less(v, heap[0], comp)) { heap_sort<T>::replace_top(heap.data(), k, T(v), comp); }
+		}
+		heap_sort<T>::sort_heap(heap.data(), heap.size(), comp);
+		return heap;
+	}
+
+private:
+	// Floyd & Rivest, "Algorithm 489: SELECT", CACM 18(3), 1975
+	template <typename Comp>
+	static void floyd_rivest(T* arr, long left, long right, long k, const Comp& comp) {
+		while (right > left) {
+			if (right - left > FLOYD_RIVEST_CUTOFF) {
+				// select within a window of about s elements around k's expected rank
+				// first, so arr[k] is already close to the answer when it becomes the pivot
+				double n = double(right - left + 1), i = double(k - left + 1);
+				double z = std::log(n), s = 0.5 * std::exp(2 * z / 3);
+				double sd = 0.5 * std::sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1 : 1);
+				long new_left = std::max(left, long(std::floor(double(k) - i * s / n + sd)));
+				long new_right = std::min(right, long(std::floor(double(k) + (n - i) * s / n + sd)));
+				floyd_rivest(arr, new_left, new_right, k, comp);
+			}
+
+			// partition arr[left..right] around t = arr[k]
+			T t = arr[k];
+			long i = left, j = right;
+			exchange(arr, size_t(left), size_t(k));
+			if (less(t, arr[right], comp)) { exchange(arr, size_t(right), size_t(left)); }
+			while (i < j) {
+				exchange(arr, size_t(i), size_t(j));
+				++i;  --j;
+				while (less(arr[i], t, comp)) { ++i; }
+				while (less(t, arr[j], comp)) { --j; }
+			}
+			if (!less(arr[left], t, comp) && !less(t, arr[left], comp)) { exchange(arr, size_t(left), size_t(j)); }
+			else {
+				++j;
+				exchange(arr, size_t(j), size_t(right));
+			}
+
+			if (j <= k) { left = j + 1; }
+			if (k <= j) { right = j - 1; }
+		}
+	}
+};
+
+#endif /* Selection_h */
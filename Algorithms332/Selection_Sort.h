@@ -10,33 +10,23 @@
 #define Selection_Sort_h
 
 #include <cassert>
-#include "utils.h"
+#include "Utils.h"
 
 
 template <typename T>
 class selection_sort {
 public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>()) {
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp()) {
 		for (size_t i = 0; i < n; ++i) {
 			size_t min = i;
 			for (size_t j = i + 1; j < n; ++j) {
 				if (less(arr[j], arr[min], comp)) { min = j; }      // return (arr[j] < arr[min]);
 			}
-			exchange(arr, i, min);
+			exchange(arr, i, min, comp);
 		}
 		assert(is_sorted(arr, n, comp));
 	}
-
-	static void sort(T* arr, size_t n) {
-	  for (size_t i = 0; i < n; ++i) {
-	    size_t min = i;
-	    for (size_t j = i + 1; j < n; ++j) {
-	      if (less(arr[j], arr[min])) { min = j; }
-	    }
-	    exchange(arr, i, min);
-	  }
-	  assert(is_sorted(arr, n));
-	}
 };
 
 
@@ -10,53 +10,143 @@
 #define Shell_Sort_h
 
 #include <cassert>
-#include "utils.h"
+#include <cstddef>
+#include "Utils.h"
 
 
-template <typename T>
+//------------------------------------------------------
+// Gap sequences for shell_sort.  gaps(n, g) writes the gaps below n into g
+// in increasing order, starting with 1, and returns how many there are;
+// MAX_GAPS (from gap_sequence) bounds the count for any size_t n, so the
+// sort keeps them in a fixed array on the stack and allocates nothing.
+//   knuth_gaps      1, 4, 13, 40, ... (3h + 1), up to the first >= n / 3
+//   ciura_gaps      1, 4, 10, 23, 57, 132, 301, 701, 1750 (Ciura 2001,
+//                   found empirically), then h = 2.25 h
+//   tokuda_gaps     ceil(h'), h' = 2.25 h' + 1 (Tokuda 1992):
+//                   1, 4, 9, 20, 46, 103, 233, 525, ...
+//   sedgewick_gaps  9 (4^k - 2^k) + 1 and 4^(k+2) - 3 2^(k+2) + 1
+//                   interleaved (Sedgewick 1986): 1, 5, 19, 41, 109, ...;
+//                   O(n^(4/3)) worst case
+//------------------------------------------------------
+struct gap_sequence {
+	static const size_t MAX_GAPS = 8 * sizeof(size_t);
+};
+
+struct knuth_gaps : gap_sequence {
+	static size_t gaps(size_t n, size_t* g) {
+		size_t k = 0, h = 1;
+		g[k++] = h;
+		while (h < n / 3) { g[k++] = h = 3 * h + 1; }
+		return k;
+	}
+};
+
+struct ciura_gaps : gap_sequence {
+	static size_t gaps(size_t n, size_t* g) {
+		static const size_t ciura[] = { 1, 4, 10, 23, 57, 132, 301, 701, 1750 };
+		size_t k = 0;
+		for (size_t h : ciura) {
+			if (k > 0 && h >= n) { return k; }
+			g[k++] = h;
+		}
+		for (size_t h = g[k - 1] * 9 / 4; h < n && h > g[k - 1]; h = h * 9 / 4) { g[k++] = h; }
+		return k;
+	}
+};
+
+struct tokuda_gaps : gap_sequence {
+	static size_t gaps(size_t n, size_t* g) {
+		size_t k = 0;
+		for (double h = 1; k == 0 || (h < double(n) && k < MAX_GAPS); h = 2.25 * h + 1) {
+			size_t gap = size_t(h);
+			g[k++] = gap < h ? gap + 1 : gap;
+			if (g[k - 1] >= n && k > 1) { return k - 1; }
+		}
+		return k;
+	}
+};
+
+struct sedgewick_gaps : gap_sequence {
+	static size_t gaps(size_t n, size_t* g) {
+		size_t k = 0;
+		g[k++] = 1;
+		for (size_t i = 0; i + 2 < 4 * sizeof(size_t); ++i) {
+			size_t p2 = size_t(1) << i, p4 = p2 * p2;
+			size_t a = 9 * (p4 - p2) + 1;                     // 1, 19, 109, 505, ...
+			size_t b = 16 * p4 - 12 * p2 + 1;                 // 5, 41, 209, 929, ...
+			if (i > 0) {
+				if (a >= n) { break; }
+				g[k++] = a;
+			}
+			if (b >= n) { break; }
+			g[k++] = b;
+		}
+		return k;
+	}
+};
+
+
+//------------------------------------------------------
+// Insertion sort on every Gaps::gaps(n)-th element, from the largest gap
+// down to 1.  In place: no scratch beyond the gap array on the stack.
+//   - an h-pass over a large array walks memory in column tiles: the
+//     array is rows of h elements, each column is h-sorted on its own,
+//     and TILE_BYTES worth of adjacent columns are sorted through every
+//     row before the next tile starts, so the rows above that an
+//     insertion walks back through are still in cache.  Passes whose
+//     rows are shorter than a tile run in plain index order.
+//   - define SHELL_SORT_CHECK_PASSES to assert that each pass leaves the
+//     array h-sorted; that is a second scan per pass, so plain debug
+//     builds only check the sorted result
+//------------------------------------------------------
+template <typename T, typename Gaps = ciura_gaps>
 class shell_sort {
 public:
-	static void sort(T* arr, size_t n, const comparator<T>& comp = fwd_comparator<T>()) {
-		int h = 1;
-		while (h < n / 3) { h = 3 * h + 1; }
+	static const size_t TILE_BYTES = 16 * 1024;
 
-		while (h >= 1) {
-			for (size_t i = h; i < n; ++i) {
-				for (size_t j = i; j >= h && less(arr[j], arr[j - h], comp); j -= h) {
-					exchange(arr, j, j - h);
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp()) {
+		if (n < 2) { return; }
+		size_t gaps[Gaps::MAX_GAPS];
+		for (size_t k = Gaps::gaps(n, gaps); k-- > 0; ) {
+			size_t h = gaps[k];
+			const size_t tile = TILE_BYTES / sizeof(T) > 0 ? TILE_BYTES / sizeof(T) : 1;
+			if (h <= tile) { h_sort(arr, h, n, h, comp); }
+			else {
+				for (size_t col = 0; col < h; col += tile) {
+					size_t width = h - col < tile ? h - col : tile;
+					for (size_t row = h; row + col < n; row += h) {
+						size_t first = row + col;
+						h_sort(arr, first, first + width < n ? first + width : n, h, comp);
+					}
 				}
 			}
-			assert(is_h_sorted(arr, n, h, comp));
-			h = h / 3;
+#ifdef SHELL_SORT_CHECK_PASSES
+			assert(is_h_sorted(arr, n, h, uninstrumented(comp)));
+#endif
 		}
 		assert(is_sorted(arr, n, comp));
 	}
 
-	static void sort(T* arr, size_t n) {
-	  int h = 1;
-	  while (h < n / 3) { h = 3 * h + 1; }
-	  
-	  while (h >= 1) {
-	    for (size_t i = h; i < n; ++i) {
-	      for (size_t j = i; j >= h && less(arr[j], arr[j - h]); j -= h) {
-	        exchange(arr, j, j - h);
-	      }
-	    }
-	    assert(is_h_sorted(arr, n, h));
-	    h = h / 3;
-	  }
-	  assert(is_sorted(arr, n));
-	}
-
 private:
-	static bool is_h_sorted(T* arr, size_t n, size_t h) {
-		for (size_t i = h; i < n; ++i) {
-			if (less(arr[i], arr[i - h])) { return false; }
+	// inserts each of arr[first..last) into its column, arr[i - h], arr[i - 2h], ...
+	template <typename Comp>
+	static void h_sort(T* arr, size_t first, size_t last, size_t h, const Comp& comp) {
+		for (size_t i = first; i < last; ++i) {
+			if (!less(arr[i], arr[i - h], comp)) { continue; }
+			T v = std::move(arr[i]);             // h-sort by shifting into a hole
+			size_t j = i;
+			do {
+				arr[j] = std::move(arr[j - h]);
+				j -= h;
+			} while (j >= h && less(v, arr[j - h], comp));
+			arr[j] = std::move(v);
+			count_moves(comp, (i - j) / h + 2);
 		}
-		return true;
 	}
 
-	static bool is_h_sorted(T* arr, size_t n, size_t h, const comparator<T>& comp) {
+	template <typename Comp>
+	static bool is_h_sorted(T* arr, size_t n, size_t h, const Comp& comp) {
 		for (size_t i = h; i < n; ++i) {
 			if (less(arr[i], arr[i - h], comp)) { return false; }
 		}
@@ -65,4 +155,4 @@ private:
 };
 
 
-#endif /* Shell_Sort_h */
\ No newline at end of file
+#endif /* Shell_Sort_h */
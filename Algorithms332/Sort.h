@@ -0,0 +1,175 @@
+//
+//  Sort.h
+//  Algorithms332
+//
+//  One sort(arr, n, comp) for callers that should not have to pick a sort
+//  class themselves.  It looks at the type, the comparator, the size, and a
+//  small sample of the input, and hands the array to the engine that suits
+//  it best:
+//
+//    sort(arr, n);                                      // ints: radix_sort
+//    sort(names.data(), names.size(), rev_comparator<std::string>());   // pdq_sort
+//    sort(arr, n, fwd_comparator<int>(), [](const sort_decision& d) { std::clog << d << "\n"; });
+//
+
+#ifndef Sort_h
+#define Sort_h
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include "Utils.h"
+#include "Insertion_Sort.h"
+#include "Merge_Sort.h"
+#include "Quick_Sort.h"
+#include "Radix_Sort.h"
+
+
+//------------------------------------------------------
+// What adaptive_sort found and what it chose; the optional hook gets one
+// per call, before the engine runs.
+//   pairs, descents, ascents   adjacent pairs probed for run structure, and
+//                              how many of them went down and up (the rest
+//                              were equal)
+//   sampled, duplicates        elements sampled for duplicate density, and
+//                              how many of them equal their sorted neighbor
+//------------------------------------------------------
+struct sort_decision {
+	const char* engine = "";
+	const char* reason = "";
+	size_t n = 0;
+	size_t pairs = 0, descents = 0, ascents = 0;
+	size_t sampled = 0, duplicates = 0;
+
+	friend std::ostream& operator<<(std::ostream& os, const sort_decision& d) {
+		return os << d.engine << " (" << d.reason << "): n=" << d.n << " descents=" << d.descents
+			<< "/" << d.pairs << " ascents=" << d.ascents << "/" << d.pairs
+			<< " duplicates=" << d.duplicates << "/" << d.sampled;
+	}
+};
+
+struct no_sort_log {
+	void operator()(const sort_decision&) const { }
+};
+
+
+//------------------------------------------------------
+// Checked in this order; the first that applies wins:
+//   insertion_sort       n <= INSERTION_CUTOFF
+//   tim_sort             the probed pairs are nearly all ascending or all
+//                        descending (at most 1/PRESORTED_FRACTION go the
+//                        other way): presorted input is a few long runs,
+//                        which the natural merge takes in linear time
+//   radix_sort           integer and floating-point keys in fwd_comparator
+//                        order, n >= RADIX_CUTOFF
+//   quick_sort_3way      at least half the sample equals a neighbor: few
+//                        distinct keys, which 3-way partitioning drops out
+//                        of the recursion as soon as they are pivots
+//   pdq_sort             everything else.  Strings land here too:
+//                        multikey_quick_sort lost to pdq_sort on every
+//                        unsorted input in sort_bench adaptive_sort
+// The probes cost a fixed number of compares, whatever n is: RUN_PROBES
+// windows of RUN_WINDOW adjacent elements spread across arr, and every
+// (n / DUPLICATE_SAMPLE)-th element, sorted by index so nothing is copied.
+//------------------------------------------------------
+template <typename T>
+class adaptive_sort {
+public:
+	static constexpr size_t INSERTION_CUTOFF = 24;
+	static constexpr size_t RADIX_CUTOFF = 1024;
+	static constexpr size_t RUN_PROBES = 32;
+	static constexpr size_t RUN_WINDOW = 8;
+	static constexpr size_t PRESORTED_FRACTION = 16;
+	static constexpr size_t DUPLICATE_SAMPLE = 64;
+
+	template <typename Comp = fwd_comparator<T>, typename Log = no_sort_log>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp(), const Log& log = Log()) {
+		sort_decision d;
+		d.n = n;
+		if (n <= INSERTION_CUTOFF) {
+			run(d, "insertion_sort", "small", log);
+			insertion_sort<T>::sort(arr, n, comp);
+			return;
+		}
+
+		probe_runs(arr, n, comp, d);
+		if (d.descents * PRESORTED_FRACTION <= d.pairs || d.ascents * PRESORTED_FRACTION <= d.pairs) {
+			run(d, "tim_sort", "presorted", log);
+			tim_sort<T>::sort(arr, n, comp);
+			return;
+		}
+
+		if constexpr (radix_order<Comp>::value) {
+			if (n >= RADIX_CUTOFF) {
+				run(d, "radix_sort", "numeric keys", log);
+				radix_sort<T>::sort(arr, n);
+				return;
+			}
+		}
+
+		probe_duplicates(arr, n, comp, d);
+		if (2 * d.duplicates >= d.sampled) {
+			run(d, "quick_sort_3way", "duplicates", log);
+			quick_sort_3way<T>::sort(arr, n, comp);
+			return;
+		}
+
+		run(d, "pdq_sort", "general", log);
+		pdq_sort<T>::sort(arr, n, comp);
+	}
+
+private:
+	template <typename Comp>
+	struct radix_order : std::integral_constant<bool,
+		std::is_same<typename uninstrumented_type<Comp>::type, fwd_comparator<T>>::value
+		&& has_radix_key<T>::value> { };
+
+	template <typename Log>
+	static void run(sort_decision& d, const char* engine, const char* reason, const Log& log) {
+		d.engine = engine;
+		d.reason = reason;
+		log(d);
+	}
+
+	template <typename Comp>
+	static void probe_runs(const T* arr, size_t n, const Comp& comp, sort_decision& d) {
+		size_t probes = std::min(RUN_PROBES, n / RUN_WINDOW);
+		for (size_t p = 0; p < probes; ++p) {
+			size_t start = p * n / probes;          // start + RUN_WINDOW <= n since n / probes >= RUN_WINDOW
+			for (size_t i = start + 1; i < start + RUN_WINDOW; ++i) {
+				++d.pairs;
+				if (less(arr[i], arr[i - 1], comp)) { ++d.descents; }
+				else if (less(arr[i - 1], arr[i], comp)) { ++d.ascents; }
+			}
+		}
+	}
+
+	template <typename Comp>
+	static void probe_duplicates(const T* arr, size_t n, const Comp& comp, sort_decision& d) {
+		size_t sample[DUPLICATE_SAMPLE];
+		size_t m = std::min(DUPLICATE_SAMPLE, n);
+		for (size_t k = 0; k < m; ++k) { sample[k] = k * n / m; }
+		auto by_value = [arr, &comp](size_t i, size_t j) { return less(arr[i], arr[j], comp); };
+		insertion_sort<size_t>::sort(sample, m, by_value);
+
+		d.sampled = m;
+		for (size_t k = 1; k < m; ++k) {
+			if (!by_value(sample[k - 1], sample[k])) { ++d.duplicates; }
+		}
+	}
+};
+
+// sorts arr[0..n) by comp with the engine adaptive_sort<T> picks for it
+template <typename T, typename Comp = fwd_comparator<T>, if_comparator<Comp, T> = 0>
+inline void sort(T* arr, size_t n, const Comp& comp = Comp()) {
+	adaptive_sort<T>::sort(arr, n, comp);
+}
+
+// ... and reports the choice to log(const sort_decision&)
+template <typename T, typename Comp, typename Log>
+inline void sort(T* arr, size_t n, const Comp& comp, const Log& log) {
+	adaptive_sort<T>::sort(arr, n, comp, log);
+}
+
+#endif /* Sort_h */
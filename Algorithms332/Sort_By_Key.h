@@ -0,0 +1,91 @@
+//
+//  Sort_By_Key.h
+//  Algorithms332
+//
+//  Decorate-sort-undecorate for sorts whose order comes from a derived key
+//  (a lower-cased name, a parsed date, ...).  Sorting the records with a
+//  comparator that derives the key recomputes it on both sides of each of
+//  the ~n lg n comparisons; sort_by_key calls key_of exactly once per
+//  record instead, sorts compact (key, index) entries, and then moves each
+//  record once into its place.
+//
+//    sort_by_key<student>::sort(arr, n, [](const student& s) { return s.id; });
+//    sort_by_key<student>::sort(arr, n, folded_name, rev_comparator<std::string>());
+//
+
+#ifndef Sort_By_Key_h
+#define Sort_By_Key_h
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Utils.h"
+#include "Quick_Sort.h"
+#include "Radix_Sort.h"
+#include "Argsort.h"
+
+
+//------------------------------------------------------
+// The result is stable: entries compare by key and then by original index,
+// so equal keys keep their input order whatever the engine does.  Engines:
+//   - radix_sort (stable, linear) for keys with a radix_key (integers other
+//     than bool, float, double) in fwd_comparator order
+//   - pdq_sort on the entries otherwise, bool and long double keys included
+// Indices are 32-bit when n allows it, to keep the entries small.
+// The records are then permuted in place with apply_permutation.
+//------------------------------------------------------
+template <typename T>
+class sort_by_key {
+public:
+	template <typename KeyOf, typename Comp = fwd_comparator<typename std::decay<
+		decltype(std::declval<KeyOf>()(std::declval<const T&>()))>::type>>
+	static void sort(T* arr, size_t n, const KeyOf& key_of, const Comp& comp = Comp())
+	{
+		if (n < 2) { return; }
+		if (n <= std::numeric_limits<uint32_t>::max()) { sort_indexed<uint32_t>(arr, n, key_of, comp); }
+		else { sort_indexed<size_t>(arr, n, key_of, comp); }
+	}
+
+private:
+	template <typename Key, typename Index>
+	struct entry {
+		Key key;
+		Index index;
+	};
+
+	template <typename Index, typename KeyOf, typename Comp>
+	static void sort_indexed(T* arr, size_t n, const KeyOf& key_of, const Comp& comp)
+	{
+		typedef typename std::decay<decltype(key_of(*arr))>::type Key;
+		typedef entry<Key, Index> Entry;
+
+		std::vector<Entry> entries(n);
+		for (size_t i = 0; i < n; ++i) {
+			entries[i].key = key_of(arr[i]);
+			entries[i].index = Index(i);
+		}
+
+		if constexpr (has_radix_key<Key>::value && std::is_same<typename uninstrumented_type<Comp>::type, fwd_comparator<Key>>::value) {
+			radix_sort<Entry>::sort(entries.data(), n, [](const Entry& e) { return e.key; });
+		}
+		else {
+			pdq_sort<Entry>::sort(entries.data(), n, [&comp](const Entry& e, const Entry& f) {
+				if (less(e.key, f.key, comp)) { return true; }
+				if (less(f.key, e.key, comp)) { return false; }
+				return e.index < f.index;
+			});
+		}
+
+		std::vector<Index> from(n);
+		for (size_t i = 0; i < n; ++i) { from[i] = entries[i].index; }
+		std::vector<Entry>().swap(entries);
+		apply_permutation(arr, from.data(), n);
+
+		assert(is_sorted(arr, n, [&](const T& v, const T& w) { return less(key_of(v), key_of(w), comp); }));
+	}
+};
+
+#endif /* Sort_By_Key_h */
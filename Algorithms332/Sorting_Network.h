@@ -0,0 +1,463 @@
+//
+//  Sorting_Network.h
+//  Algorithms332
+//
+//  Vectorized bitonic sorting networks for small blocks (up to 64 elements)
+//  of 32-bit ints, floats and 64-bit ints, used as the leaf case of the
+//  quick sorts and (integer keys only) the merge sorts.  A network does a fixed sequence of min/max
+//  compare-exchanges, so it has no data-dependent branches to mispredict and
+//  each min/max handles a whole SIMD register of elements.
+//
+//  AVX2 is used when compiled with -mavx2, SSE4.1 (SSE4.2 for 64-bit ints)
+//  otherwise, and a branchless scalar network when neither is available.
+//
+//  simd_merge<T> is the matching merge kernel for 32-bit keys; it checks for
+//  AVX2 at run time, so it needs no compiler flags.
+//
+
+#ifndef Sorting_Network_h
+#define Sorting_Network_h
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "Utils.h"
+
+// GCC and Clang can compile AVX2 functions into a build that does not
+// assume AVX2 (target attribute) and check the CPU at run time
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SORTING_NETWORK_AVX2_DISPATCH 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#if defined(__AVX2__) || defined(__SSE4_1__) || defined(SORTING_NETWORK_AVX2_DISPATCH)
+#include <immintrin.h>
+#endif
+
+
+//------------------------------------------------------
+// One SIMD register of T: WIDTH lanes, min/max, and the two lane operations
+// an in-register bitonic stage needs.  swap_lanes<J> moves lane l ^ J into
+// lane l; blend(a, b, mask<J, K>()) takes b in every lane l where
+// ((l & J) != 0) != ((l & K) != 0), i.e. where that lane keeps the max.
+// The primary template is the scalar fallback (one lane, never shuffled).
+//
+// On a tie (or a NaN) min(a, b) and max(a, b) return different operands,
+// so a compare-exchange always keeps both values: -0.0f and +0.0f, or a
+// NaN, are never dropped or doubled.  The SSE/AVX min_ps and max_ps return
+// their second operand on a tie, hence max_ps(b, a).  A lane and its
+// partner see the operands the other way around, so the in-register
+// stages take min(v, s) and max(s, v).
+//------------------------------------------------------
+template <typename T, typename Enable = void>
+struct network_vec {
+	typedef T reg;
+	static const size_t WIDTH = 1;
+	static const bool simd = false;
+	static reg load(const T* p) { return *p; }
+	static void store(T* p, reg v) { *p = v; }
+	static reg min(reg a, reg b) { return b < a ? b : a; }
+	static reg max(reg a, reg b) { return b < a ? a : b; }
+};
+
+template <size_t W, size_t J, size_t K>
+struct network_lane {
+	static const bool takes_max = ((W & J) != 0) != ((W & K) != 0);
+};
+
+#if defined(__AVX2__)
+
+template <typename T>
+struct network_vec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value
+	&& sizeof(T) == 4>::type> {
+	typedef __m256i reg;
+	static const size_t WIDTH = 8;
+	static const bool simd = true;
+	static reg load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(T* p, reg v) { _mm256_storeu_si256((__m256i*)p, v); }
+	static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+	static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+	template <size_t J> static reg swap_lanes(reg v) {
+		return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+	}
+	template <size_t J, size_t K> static reg mask() {
+		return _mm256_setr_epi32(-int(network_lane<0, J, K>::takes_max), -int(network_lane<1, J, K>::takes_max),
+			-int(network_lane<2, J, K>::takes_max), -int(network_lane<3, J, K>::takes_max),
+			-int(network_lane<4, J, K>::takes_max), -int(network_lane<5, J, K>::takes_max),
+			-int(network_lane<6, J, K>::takes_max), -int(network_lane<7, J, K>::takes_max));
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm256_blendv_epi8(a, b, m); }
+};
+
+template <>
+struct network_vec<float> {
+	typedef __m256 reg;
+	static const size_t WIDTH = 8;
+	static const bool simd = true;
+	static reg load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+	static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+	static reg max(reg a, reg b) { return _mm256_max_ps(b, a); }
+	template <size_t J> static reg swap_lanes(reg v) {
+		return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+	}
+	template <size_t J, size_t K> static reg mask() {
+		return _mm256_castsi256_ps(network_vec<int32_t>::mask<J, K>());
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm256_blendv_ps(a, b, m); }
+};
+
+template <typename T>
+struct network_vec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value
+	&& sizeof(T) == 8>::type> {
+	typedef __m256i reg;
+	static const size_t WIDTH = 4;
+	static const bool simd = true;
+	static reg load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(T* p, reg v) { _mm256_storeu_si256((__m256i*)p, v); }
+	static reg min(reg a, reg b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+	static reg max(reg a, reg b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+	template <size_t J> static reg swap_lanes(reg v) {
+		return _mm256_permute4x64_epi64(v, J == 1 ? 0xB1 : 0x4E);
+	}
+	template <size_t J, size_t K> static reg mask() {
+		return _mm256_setr_epi64x(-(long long)network_lane<0, J, K>::takes_max, -(long long)network_lane<1, J, K>::takes_max,
+			-(long long)network_lane<2, J, K>::takes_max, -(long long)network_lane<3, J, K>::takes_max);
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm256_blendv_epi8(a, b, m); }
+};
+
+#elif defined(__SSE4_1__)
+
+template <typename T>
+struct network_vec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value
+	&& sizeof(T) == 4>::type> {
+	typedef __m128i reg;
+	static const size_t WIDTH = 4;
+	static const bool simd = true;
+	static reg load(const T* p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void store(T* p, reg v) { _mm_storeu_si128((__m128i*)p, v); }
+	static reg min(reg a, reg b) { return _mm_min_epi32(a, b); }
+	static reg max(reg a, reg b) { return _mm_max_epi32(a, b); }
+	template <size_t J> static reg swap_lanes(reg v) { return _mm_shuffle_epi32(v, J == 1 ? 0xB1 : 0x4E); }
+	template <size_t J, size_t K> static reg mask() {
+		return _mm_setr_epi32(-int(network_lane<0, J, K>::takes_max), -int(network_lane<1, J, K>::takes_max),
+			-int(network_lane<2, J, K>::takes_max), -int(network_lane<3, J, K>::takes_max));
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm_blendv_epi8(a, b, m); }
+};
+
+template <>
+struct network_vec<float> {
+	typedef __m128 reg;
+	static const size_t WIDTH = 4;
+	static const bool simd = true;
+	static reg load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+	static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+	static reg max(reg a, reg b) { return _mm_max_ps(b, a); }
+	template <size_t J> static reg swap_lanes(reg v) { return _mm_shuffle_ps(v, v, J == 1 ? 0xB1 : 0x4E); }
+	template <size_t J, size_t K> static reg mask() {
+		return _mm_castsi128_ps(network_vec<int32_t>::mask<J, K>());
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm_blendv_ps(a, b, m); }
+};
+
+#if defined(__SSE4_2__)
+template <typename T>
+struct network_vec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value
+	&& sizeof(T) == 8>::type> {
+	typedef __m128i reg;
+	static const size_t WIDTH = 2;
+	static const bool simd = true;
+	static reg load(const T* p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void store(T* p, reg v) { _mm_storeu_si128((__m128i*)p, v); }
+	static reg min(reg a, reg b) { return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+	static reg max(reg a, reg b) { return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+	template <size_t J> static reg swap_lanes(reg v) { return _mm_shuffle_epi32(v, 0x4E); }
+	template <size_t J, size_t K> static reg mask() {
+		return _mm_set_epi64x(-(long long)network_lane<1, J, K>::takes_max, -(long long)network_lane<0, J, K>::takes_max);
+	}
+	static reg blend(reg a, reg b, reg m) { return _mm_blendv_epi8(a, b, m); }
+};
+#endif
+
+#endif
+
+
+// Types and comparators for which the quick sorts finish small subarrays
+// with sorting_network<T> instead of insertion sort: 32-bit and 64-bit
+// signed ints, and float when it has SIMD lanes, in their natural
+// (fwd_comparator) order.  (The scalar float compare-exchange that keeps
+// both operands of a tie compiles to a branch, and loses to insertion sort.)
+// The result is a permutation of the input, but keys that compare equal
+// can come out in either order, so -0.0f and +0.0f are not kept stable.
+template <typename T, typename Comp>
+struct use_sorting_network : std::integral_constant<bool,
+	((std::is_same<T, float>::value && network_vec<float>::simd) || (std::is_integral<T>::value
+		&& std::is_signed<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)))
+	&& std::is_same<typename uninstrumented_type<Comp>::type, fwd_comparator<T>>::value> { };
+
+// ... and for which the stable merge sorts do (with simd_merge as their
+// merge): the integer keys only, where equal keys are indistinguishable
+template <typename T, typename Comp>
+struct use_stable_sorting_network : std::integral_constant<bool,
+	use_sorting_network<T, Comp>::value && std::is_integral<T>::value> { };
+
+
+//------------------------------------------------------
+// Bitonic sort of n <= MAX elements.  The block is copied into the smallest
+// power-of-two buffer (at least one register) that holds it, padded with the
+// largest T, and kept in R registers of WIDTH lanes: element i is lane
+// i % WIDTH of register i / WIDTH.  A compare-exchange of distance J >= WIDTH
+// is then a min/max between whole registers; one of distance J < WIDTH is a
+// lane shuffle, a min/max and a blend within each register.  The stages are
+// template-unrolled, so every shuffle pattern and blend mask is a constant.
+//
+// MAX is 64 with SIMD and 16 for the scalar network, whose compare count
+// (n/4 lg n (lg n + 1)) stops beating insertion sort above that.
+//------------------------------------------------------
+template <typename T>
+class sorting_network {
+	typedef network_vec<T> V;
+	typedef typename V::reg reg;
+
+public:
+	static const size_t MAX = V::simd ? 64 : 16;
+
+	static void sort(T* arr, size_t n)
+	{
+		sort_unchecked(arr, n);
+		assert(is_sorted(arr, n));
+	}
+
+	// sort() without the debug check, which a NaN in arr would fail
+	static void sort_unchecked(T* arr, size_t n)
+	{
+		assert(n <= MAX);
+		if (n < 2) { return; }
+		size_t p = V::WIDTH;
+		while (p < n) { p *= 2; }
+		switch (p / V::WIDTH) {
+		case 1: sort_padded<1>(arr, n); break;
+		case 2: sort_padded<2>(arr, n); break;
+		case 4: sort_padded<4>(arr, n); break;
+		case 8: sort_padded<8>(arr, n); break;
+		case 16: sort_padded<16>(arr, n); break;
+		case 32: sort_padded<32>(arr, n); break;
+		case 64: sort_padded<64>(arr, n); break;
+		}
+	}
+
+private:
+	template <size_t R>
+	static void sort_padded(T* arr, size_t n)
+	{
+		const size_t P = R * V::WIDTH;
+		T buf[P];
+		for (size_t i = 0; i < n; ++i) { buf[i] = arr[i]; }
+		for (size_t i = n; i < P; ++i) { buf[i] = pad(); }
+
+		reg v[R];
+		for (size_t r = 0; r < R; ++r) { v[r] = V::load(buf + r * V::WIDTH); }
+		stages<R, 2, 1>(v);
+		for (size_t r = 0; r < R; ++r) { V::store(buf + r * V::WIDTH, v[r]); }
+
+		if constexpr (std::numeric_limits<T>::has_quiet_NaN) {
+			// the pads are the largest keys and end up in buf[n..P), unless a NaN
+			// (unordered) kept one from moving past it: drop P - n pads wherever they are
+			size_t pads = P - n;
+			for (size_t i = 0, k = 0; k < n; ++i) {
+				if (pads > 0 && buf[i] == pad()) { --pads;  continue; }
+				arr[k++] = buf[i];
+			}
+		}
+		else {
+			for (size_t i = 0; i < n; ++i) { arr[i] = buf[i]; }
+		}
+	}
+
+	// bitonic sort: for K = 2, 4, ..., P merge runs of K / 2 with distances J = K / 2, ..., 1;
+	// element i goes ascending when (i & K) == 0
+	template <size_t R, size_t K, size_t J>
+	static void stages(reg* v)
+	{
+		stage<R, K, J>(v);
+		if constexpr (J > 1) { stages<R, K, J / 2>(v); }
+		else if constexpr (K < R * V::WIDTH) { stages<R, 2 * K, K>(v); }
+	}
+
+	template <size_t R, size_t K, size_t J>
+	static void stage(reg* v)
+	{
+		if constexpr (J >= V::WIDTH) {
+			const size_t JR = J / V::WIDTH;
+			for (size_t r = 0; r < R; ++r) {
+				if (r & JR) { continue; }
+				bool ascending = ((r * V::WIDTH) & K) == 0;
+				reg lo = V::min(v[r], v[r + JR]), hi = V::max(v[r], v[r + JR]);
+				v[r] = ascending ? lo : hi;
+				v[r + JR] = ascending ? hi : lo;
+			}
+		}
+		else {
+			// K < WIDTH: direction alternates within the register (folded into the mask);
+			// otherwise it is the same for the whole register
+			const reg m = V::template mask<J, (K < V::WIDTH ? K : 0)>();
+			for (size_t r = 0; r < R; ++r) {
+				reg s = V::template swap_lanes<J>(v[r]);
+				reg lo = V::min(v[r], s), hi = V::max(s, v[r]);      // see network_vec
+				bool ascending = K < V::WIDTH || ((r * V::WIDTH) & K) == 0;
+				v[r] = ascending ? V::blend(lo, hi, m) : V::blend(hi, lo, m);
+			}
+		}
+	}
+
+	static T pad()
+	{
+		return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+	}
+};
+
+
+//------------------------------------------------------
+// Merge of two sorted runs of 32-bit ints or floats, 8 elements at a time
+// (Inoue et al.): one register holds the 8 largest elements seen so far;
+// each step loads the next 8 from whichever input has the smaller head,
+// and a bitonic merge network (reverse, min/max, then three in-register
+// half-cleaners) leaves the 8 smallest of the 16 in the other register,
+// which is stored.  The last < 8 elements of an input and the 8 held back
+// are merged by the scalar loop.
+//
+// merge() returns false without touching out when it cannot run (no AVX2
+// on this CPU, a type other than 32-bit keys, or an input shorter than 8),
+// so callers fall back to their own merge.  The output is a permutation of
+// the inputs (min and max keep both operands of a tie, as in network_vec),
+// but ties are not kept in input order, so the merge is not stable for
+// -0.0f/+0.0f.
+//------------------------------------------------------
+template <typename T>
+class simd_merge {
+public:
+	static const size_t WIDTH = 8;
+	static const bool supported = (std::is_same<T, float>::value
+		|| (std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4));
+
+	static bool available()
+	{
+#if defined(SORTING_NETWORK_AVX2_DISPATCH)
+		static const bool has_avx2 = __builtin_cpu_supports("avx2");
+		return supported && has_avx2;
+#else
+		return false;
+#endif
+	}
+
+	// merges a[0..m) and b[0..n) into out[0..m + n)
+	static bool merge(const T* a, size_t m, const T* b, size_t n, T* out)
+	{
+		if (!merge_unchecked(a, m, b, n, out)) { return false; }
+		assert(is_sorted(out, m + n));
+		return true;
+	}
+
+	// merge() without the debug check, which a NaN in the inputs would fail
+	static bool merge_unchecked(const T* a, size_t m, const T* b, size_t n, T* out)
+	{
+		if (m < WIDTH || n < WIDTH || !available()) { return false; }
+#if defined(SORTING_NETWORK_AVX2_DISPATCH)
+		merge_avx2(a, a + m, b, b + n, out);
+#endif
+		return true;
+	}
+
+	static void merge_scalar(const T* a, const T* a_end, const T* b, const T* b_end, T* out)
+	{
+		while (a != a_end && b != b_end) { *out++ = *b < *a ? *b++ : *a++; }
+		while (a != a_end) { *out++ = *a++; }
+		while (b != b_end) { *out++ = *b++; }
+	}
+
+#if defined(SORTING_NETWORK_AVX2_DISPATCH)
+private:
+	// int keys live in __m256i and floats in __m256; these hide the difference
+	struct ops_int {
+		typedef __m256i reg;
+		AVX2_TARGET static reg load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+		AVX2_TARGET static void store(T* p, reg v) { _mm256_storeu_si256((__m256i*)p, v); }
+		AVX2_TARGET static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+		AVX2_TARGET static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+		AVX2_TARGET static reg permute(reg v, __m256i idx) { return _mm256_permutevar8x32_epi32(v, idx); }
+		AVX2_TARGET static reg blend(reg a, reg b, __m256i m) { return _mm256_blendv_epi8(a, b, m); }
+	};
+	struct ops_float {
+		typedef __m256 reg;
+		AVX2_TARGET static reg load(const T* p) { return _mm256_loadu_ps((const float*)p); }
+		AVX2_TARGET static void store(T* p, reg v) { _mm256_storeu_ps((float*)p, v); }
+		AVX2_TARGET static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+		AVX2_TARGET static reg max(reg a, reg b) { return _mm256_max_ps(b, a); }   // see network_vec
+		AVX2_TARGET static reg permute(reg v, __m256i idx) { return _mm256_permutevar8x32_ps(v, idx); }
+		AVX2_TARGET static reg blend(reg a, reg b, __m256i m) { return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(m)); }
+	};
+	typedef typename std::conditional<std::is_same<T, float>::value, ops_float, ops_int>::type ops;
+	typedef typename ops::reg reg;
+
+	// lo, hi sorted -> lo = the 8 smallest, hi = the 8 largest, both sorted
+	AVX2_TARGET static void merge_regs(reg& lo, reg& hi)
+	{
+		reg r = ops::permute(hi, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+		reg l = ops::min(lo, r);
+		reg h = ops::max(lo, r);
+		half_clean(l, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3), _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1));
+		half_clean(h, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3), _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1));
+		half_clean(l, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1));
+		half_clean(h, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1));
+		half_clean(l, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1));
+		half_clean(h, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1));
+		lo = l;
+		hi = h;
+	}
+
+	// compare-exchange of every lane with its partner idx[lane]; lanes set in takes_max keep the max
+	AVX2_TARGET static void half_clean(reg& v, __m256i idx, __m256i takes_max)
+	{
+		reg s = ops::permute(v, idx);
+		v = ops::blend(ops::min(v, s), ops::max(s, v), takes_max);
+	}
+
+	AVX2_TARGET static void merge_avx2(const T* a, const T* a_end, const T* b, const T* b_end, T* out)
+	{
+		reg lo = ops::load(a), hi = ops::load(b);
+		a += WIDTH;
+		b += WIDTH;
+		merge_regs(lo, hi);
+		ops::store(out, lo);
+		out += WIDTH;
+
+		while (size_t(a_end - a) >= WIDTH && size_t(b_end - b) >= WIDTH) {
+			bool take_b = *b < *a;          // select without a branch: this one is unpredictable
+			lo = ops::load(take_b ? b : a);
+			a += take_b ? 0 : WIDTH;
+			b += take_b ? WIDTH : 0;
+			merge_regs(lo, hi);
+			ops::store(out, lo);
+			out += WIDTH;
+		}
+
+		// hi and the < 8 left of one input into buf, then buf with the rest of the other
+		T held[WIDTH], buf[2 * WIDTH];
+		ops::store(held, hi);
+		if (size_t(a_end - a) < WIDTH) {
+			merge_scalar(held, held + WIDTH, a, a_end, buf);
+			merge_scalar(buf, buf + WIDTH + (a_end - a), b, b_end, out);
+		}
+		else {
+			merge_scalar(held, held + WIDTH, b, b_end, buf);
+			merge_scalar(buf, buf + WIDTH + (b_end - b), a, a_end, out);
+		}
+	}
+#endif
+};
+
+#endif /* Sorting_Network_h */
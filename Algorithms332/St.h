@@ -83,7 +83,7 @@ private:
 
 public:
 	//  binary_search_st() : binary_search_st(fwd_comparator<Key>(), 2) { }
-	binary_search_st(const comparator<Key>& comp = fwd_comparator<Key>(), size_t capacity = 2)
+	binary_search_st(const comparator<Key>& comp = virtual_comparator<Key, fwd_comparator<Key>>(), size_t capacity = 2)
 		: size_(0), comp_(comp), keys_(capacity), values_(capacity) { }
 
 	void put(Key key, const Value& val) {
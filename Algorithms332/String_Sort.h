@@ -0,0 +1,184 @@
+//
+//  String_Sort.h
+//  Algorithms332
+//
+//  Multikey (3-way radix) quicksort for arrays of std::string, after
+//  Bentley & Sedgewick, "Fast Algorithms for Sorting and Searching Strings".
+//  Every string in a subarray shares the prefix [0, d), so partitioning looks
+//  at one position d at a time and never rescans the shared prefix the way
+//  a comparison sort's string compares do.
+//
+
+#ifndef String_Sort_h
+#define String_Sort_h
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Utils.h"
+
+
+template <typename T>
+class multikey_quick_sort {
+public:
+	static const size_t INSERTION_CUTOFF = 16;
+
+	// Drop-in for the other sorts' sort(arr, n, comp); only the natural string
+	// order and its reverse are radix orders, so those are the comparators accepted.
+	template <typename Comp = fwd_comparator<T>>
+	static void sort(T* arr, size_t n, const Comp& comp = Comp()) {
+		static_assert(std::is_same<Comp, fwd_comparator<T>>::value || std::is_same<Comp, rev_comparator<T>>::value,
+			"multikey_quick_sort sorts by byte order: use fwd_comparator or rev_comparator");
+		no_tally tally;
+		sort_cached(arr, n, tally);
+		if (std::is_same<Comp, rev_comparator<T>>::value) {
+			for (size_t lo = 0, hi = n; lo + 1 < hi; ++lo, --hi) { std::swap(arr[lo], arr[hi - 1]); }
+		}
+		assert(is_sorted(arr, n, comp));
+	}
+
+	// Partitions on 8 bytes at a time: the next 8 bytes of every string in the
+	// subarray are cached in a parallel array as one big-endian integer, so a
+	// partitioning step compares integers and touches no string memory.
+	// `bytes` (if given a size_t) counts string bytes read.
+	template <typename Tally>
+	static void sort_cached(T* arr, size_t n, Tally& bytes) {
+		if (n < 2) { return; }
+		std::vector<uint64_t> keys(n);
+		fill_keys(arr, keys.data(), 0, n, 0, bytes);
+		sort_cached(arr, keys.data(), 0, n, 0, bytes);
+		assert(is_sorted(arr, n));
+	}
+
+	// The classic one-character-at-a-time version.
+	template <typename Tally>
+	static void sort_bytes(T* arr, size_t n, Tally& bytes) {
+		if (n < 2) { return; }
+		sort_bytes(arr, 0, n, 0, bytes);
+		assert(is_sorted(arr, n));
+	}
+
+	struct no_tally {
+		no_tally& operator+=(size_t) { return *this; }
+	};
+
+private:
+	// -1 past the end, so shorter strings sort first
+	static int char_at(const T& s, size_t d) {
+		return d < s.size() ? (unsigned char)s[d] : -1;
+	}
+
+	// bytes [d, d + 8) as a big-endian integer, zero-padded past the end
+	static uint64_t key_at(const T& s, size_t d) {
+		uint64_t key = 0;
+		for (size_t i = 0; i < 8; ++i) {
+			key <<= 8;
+			if (d + i < s.size()) { key |= (unsigned char)s[d + i]; }
+		}
+		return key;
+	}
+
+	template <typename Tally>
+	static void fill_keys(T* arr, uint64_t* keys, size_t low, size_t high, size_t d, Tally& bytes) {
+		for (size_t i = low; i < high; ++i) {
+			keys[i] = key_at(arr[i], d);
+			bytes += arr[i].size() > d ? std::min<size_t>(8, arr[i].size() - d) : 0;
+		}
+	}
+
+	// arr[low..high) all share the prefix [0, d)
+	template <typename Tally>
+	static void sort_cached(T* arr, uint64_t* keys, size_t low, size_t high, size_t d, Tally& bytes) {
+		while (high - low > INSERTION_CUTOFF) {
+			uint64_t v = median_of_3(keys[low], keys[low + (high - low) / 2], keys[high - 1]);
+
+			// a[low..lt) < v = a[lt..gt) < a[gt..high)
+			size_t lt = low, i = low, gt = high;
+			while (i < gt) {
+				if (keys[i] < v) { swap_both(arr, keys, lt++, i++); }
+				else if (keys[i] > v) { swap_both(arr, keys, i, --gt); }
+				else { ++i; }
+			}
+
+			sort_cached(arr, keys, low, lt, d, bytes);
+			sort_cached(arr, keys, gt, high, d, bytes);
+
+			// Every string in the middle matches on [d, d + 8).  If none of them
+			// goes past d + 8 they differ at most in trailing '\0's (i.e. length)
+			// and a plain insertion sort finishes them; otherwise move on to d + 8.
+			size_t longest = 0;
+			for (size_t k = lt; k < gt; ++k) { longest = std::max(longest, arr[k].size()); }
+			if (longest <= d + 8) {
+				insertion_sort(arr, lt, gt, d, bytes);
+				return;
+			}
+			low = lt;
+			high = gt;
+			d += 8;
+			fill_keys(arr, keys, low, high, d, bytes);
+		}
+		insertion_sort(arr, low, high, d, bytes);
+	}
+
+	template <typename Tally>
+	static void sort_bytes(T* arr, size_t low, size_t high, size_t d, Tally& bytes) {
+		while (high - low > INSERTION_CUTOFF) {
+			int v = median_of_3(char_at(arr[low], d), char_at(arr[low + (high - low) / 2], d),
+				char_at(arr[high - 1], d));
+
+			size_t lt = low, i = low, gt = high;
+			while (i < gt) {
+				int c = char_at(arr[i], d);
+				bytes += 1;
+				if (c < v) { std::swap(arr[lt++], arr[i++]); }
+				else if (c > v) { std::swap(arr[i], arr[--gt]); }
+				else { ++i; }
+			}
+
+			sort_bytes(arr, low, lt, d, bytes);
+			sort_bytes(arr, gt, high, d, bytes);
+			if (v < 0) { return; }                 // the middle strings all end at d: equal
+			low = lt;
+			high = gt;
+			++d;
+		}
+		insertion_sort(arr, low, high, d, bytes);
+	}
+
+	// insertion sort of arr[low..high), comparing from position d on
+	template <typename Tally>
+	static void insertion_sort(T* arr, size_t low, size_t high, size_t d, Tally& bytes) {
+		for (size_t i = low + 1; i < high; ++i) {
+			for (size_t j = i; j > low && less_from(arr[j], arr[j - 1], d, bytes); --j) {
+				std::swap(arr[j], arr[j - 1]);
+			}
+		}
+	}
+
+	template <typename Tally>
+	static bool less_from(const T& v, const T& w, size_t d, Tally& bytes) {
+		size_t n = std::min(v.size(), w.size());
+		size_t i = std::min(d, n);          // d can pass the end of strings that only differ in trailing '\0's
+		size_t first = i;
+		while (i < n && v[i] == w[i]) { ++i; }
+		bytes += 2 * (i - first + 1);
+		if (i == n) { return v.size() < w.size(); }
+		return (unsigned char)v[i] < (unsigned char)w[i];
+	}
+
+	static void swap_both(T* arr, uint64_t* keys, size_t i, size_t j) {
+		std::swap(arr[i], arr[j]);
+		std::swap(keys[i], keys[j]);
+	}
+
+	template <typename K>
+	static K median_of_3(K a, K b, K c) {
+		return a < b ? (b < c ? b : a < c ? c : a) : (c < b ? b : c < a ? c : a);
+	}
+};
+
+#endif /* String_Sort_h */
@@ -0,0 +1,203 @@
+//
+//  Thread_Pool.h
+//  Algorithms332
+//
+//  Work-stealing thread pool and fork/join task_group used by the parallel
+//  sorts.  Each worker owns a deque: it pushes and pops its own work at the
+//  back (LIFO, cache-warm) and idle workers steal from the front of other
+//  deques (FIFO, i.e. the biggest pieces of a divide-and-conquer split).
+//
+//  A pool of `threads` participants spawns threads - 1 workers; the thread
+//  that waits on a task_group is the last participant and runs tasks too, so
+//  work_stealing_pool(1) runs everything on the caller.
+//
+
+#ifndef Thread_Pool_h
+#define Thread_Pool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class work_stealing_pool {
+public:
+	typedef std::function<void()> task;
+
+	explicit work_stealing_pool(size_t threads = 0)
+		: queues_(threads == 0 ? hardware_threads() : threads), queued_(0), done_(false) {
+		for (size_t i = 0; i < queues_.size(); ++i) { queues_[i].reset(new task_queue); }
+		for (size_t i = 1; i < queues_.size(); ++i) {
+			workers_.emplace_back([this, i] { worker_loop(i); });
+		}
+	}
+
+	~work_stealing_pool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			done_ = true;
+		}
+		wake_.notify_all();
+		for (std::thread& t : workers_) { t.join(); }
+	}
+
+	work_stealing_pool(const work_stealing_pool&) = delete;
+	work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+	size_t size() const { return queues_.size(); }
+
+	static size_t hardware_threads() {
+		size_t n = std::thread::hardware_concurrency();
+		return n == 0 ? 1 : n;
+	}
+
+	// pushes onto the calling worker's own deque (queue 0 for outside threads)
+	void submit(task t) {
+		task_queue& q = *queues_[my_index()];
+		{
+			std::lock_guard<std::mutex> lock(q.mutex);
+			q.tasks.push_back(std::move(t));
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);    // no lost wake-up against worker_loop
+			++queued_;
+		}
+		wake_.notify_one();
+	}
+
+	// runs one pending task: our own newest first, otherwise steal someone else's oldest
+	bool run_one() {
+		size_t me = my_index();
+		task t;
+		if (pop_back(me, t) || steal(me, t)) {
+			--queued_;
+			t();
+			return true;
+		}
+		return false;
+	}
+
+private:
+	struct task_queue {
+		std::mutex mutex;
+		std::deque<task> tasks;
+	};
+
+	struct thread_slot {
+		const work_stealing_pool* pool;
+		size_t index;
+	};
+
+	static thread_slot& slot() {
+		static thread_local thread_slot s = { nullptr, 0 };
+		return s;
+	}
+
+	size_t my_index() const { return slot().pool == this ? slot().index : 0; }
+
+	bool pop_back(size_t i, task& t) {
+		task_queue& q = *queues_[i];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.tasks.empty()) { return false; }
+		t = std::move(q.tasks.back());
+		q.tasks.pop_back();
+		return true;
+	}
+
+	bool steal(size_t me, task& t) {
+		for (size_t k = 1; k < queues_.size(); ++k) {
+			task_queue& q = *queues_[(me + k) % queues_.size()];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (q.tasks.empty()) { continue; }
+			t = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	void worker_loop(size_t index) {
+		slot() = { this, index };
+		while (true) {
+			if (run_one()) { continue; }
+
+			std::unique_lock<std::mutex> lock(sleep_mutex_);
+			wake_.wait(lock, [this] { return done_ || queued_ > 0; });
+			if (done_) { return; }
+		}
+	}
+
+	std::vector<std::unique_ptr<task_queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<long> queued_;         // may dip below 0 briefly when a task is stolen before it is counted
+
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	bool done_;
+};
+
+
+//------------------------------------------------------
+// fork/join over a work_stealing_pool: run() forks, wait() joins.
+// wait() keeps executing pool tasks while it waits, so nested
+// groups inside tasks cannot deadlock the pool.
+// A task that throws still counts as finished; wait() rethrows the
+// first such exception once every task in the group is done.
+//------------------------------------------------------
+class task_group {
+public:
+	explicit task_group(work_stealing_pool& pool) : pool_(pool), pending_(0) { }
+	~task_group() { join(); }      // no rethrow from a destructor; call wait() to see errors
+
+	template <typename F>
+	void run(F f) {
+		++pending_;
+		pool_.submit([this, f] {
+			finished guard(pending_);
+			try { f(); }
+			catch (...) { fail(std::current_exception()); }
+		});
+	}
+
+	void wait() {
+		join();
+		std::exception_ptr e;
+		{
+			std::lock_guard<std::mutex> lock(error_mutex_);
+			std::swap(e, error_);
+		}
+		if (e) { std::rethrow_exception(e); }
+	}
+
+private:
+	// decrements pending_ however the task leaves
+	struct finished {
+		explicit finished(std::atomic<size_t>& pending) : pending(pending) { }
+		~finished() { --pending; }
+		std::atomic<size_t>& pending;
+	};
+
+	void join() {
+		while (pending_ > 0) {
+			if (!pool_.run_one()) { std::this_thread::yield(); }
+		}
+	}
+
+	void fail(std::exception_ptr e) {
+		std::lock_guard<std::mutex> lock(error_mutex_);
+		if (!error_) { error_ = e; }
+	}
+
+	work_stealing_pool& pool_;
+	std::atomic<size_t> pending_;
+	std::mutex error_mutex_;
+	std::exception_ptr error_;
+};
+
+#endif /* Thread_Pool_h */
@@ -13,6 +13,8 @@
 #include <fstream>
 #include <cstdlib>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 
 #define ARGC_ERROR  1
@@ -116,6 +118,14 @@ inline char* strstrip(char* s) {
 //==========================================================================
 // sorting utilities
 //==========================================================================
+// The sorts take their comparator as a template parameter, so any callable
+// with the shape bool(const T&, const T&) works and the compiler can inline
+// the comparison.  fwd_comparator / rev_comparator / null_comparator are
+// stateless functors for exactly that purpose.
+//
+// comparator<T> remains the runtime-polymorphic base for code that has to
+// hold a comparator by reference (e.g., binary_search_st); passing one to a
+// sort still works, but every comparison is then a virtual call.
 template <typename T>
 struct comparator {
 	comparator() { }
@@ -123,20 +133,25 @@ struct comparator {
 };
 
 template <typename T>
-struct fwd_comparator : public comparator<T> {
-	virtual bool operator()(const T& v, const T& w) const override {
-		return v < w;
-	}
+struct fwd_comparator {
+	bool operator()(const T& v, const T& w) const { return v < w; }
 };
 
 template <typename T>
-struct rev_comparator : public comparator<T> {
-	virtual bool operator()(const T& v, const T& w) const override { return w < v; }
+struct rev_comparator {
+	bool operator()(const T& v, const T& w) const { return w < v; }
 };
 
 template <typename T>
-struct null_comparator : public comparator<T> {
-	virtual bool operator()(const T& v, const T& w) const override { return false; }
+struct null_comparator {
+	bool operator()(const T& v, const T& w) const { return false; }
+};
+
+// wraps a stateless functor so it can be handed out as a comparator<T>&
+template <typename T, typename Comp>
+struct virtual_comparator : public comparator<T> {
+	virtual bool operator()(const T& v, const T& w) const override { return comp_(v, w); }
+	Comp comp_;
 };
 
 template <typename T>
@@ -151,22 +166,115 @@ struct comparator_lambda : public comparator<T> {
 	std::function <bool(const T&, const T&)> const lambda_;
 };
 
-template <typename T>
-inline bool less(T& v, T& w) { return v < w; }
+// enabled only when Comp can order two T's -- keeps a call like
+// sort(arr, low, high) from deducing Comp = size_t
+template <typename Comp, typename T>
+using if_comparator = typename std::enable_if<
+	std::is_invocable_r<bool, const Comp&, const T&, const T&>::value, int>::type;
 
-template <typename T>
-inline bool less(T& v, T& w, const comparator<T>& comp) {
-	bool value = comp(v, w);
-	return value;
+//--------------------------------------------------------------------------
+// Instrumentation.  Wrapping a sort's comparator in instrumented<Comp> makes
+// the sort record its work in a sort_stats:
+//
+//   sort_stats stats;
+//   merge_sort<int>::sort(arr, n, instrument(stats, fwd_comparator<int>()));
+//   std::clog << "merge_sort: " << stats << "\n";
+//
+// The sorts report through the hooks below (count_moves, count_swaps,
+// count_scratch, recursion_depth, and exchange(a, i, j, comp)), which take the comparator
+// they already carry.  For any other comparator the hooks are empty inline
+// functions, so an uninstrumented sort compiles exactly as before.
+// Compares are counted by the wrapper itself; the is_sorted debug checks
+// use the unwrapped comparator and are not counted.
+// A sort picks its code path from the unwrapped comparator type, so an
+// instrumented run takes the same path as a plain one.  The parts of that
+// path that never call the comparator (sorting-network leaves, SIMD merges
+// and radix passes) add no compares, and only the moves of the merges
+// around them.
+//--------------------------------------------------------------------------
+struct sort_stats {
+	size_t compares = 0;
+	size_t moves = 0;             // element moves and copies; a swap is 3
+	size_t swaps = 0;
+	size_t scratch_bytes = 0;     // allocated for scratch arrays
+	size_t max_depth = 0;         // deepest nesting of the sort's recursive calls
+	size_t depth = 0;             // current nesting, while a sort runs
+
+	void reset() { *this = sort_stats(); }
+
+	friend std::ostream& operator<<(std::ostream& os, const sort_stats& s) {
+		return os << "compares=" << s.compares << " moves=" << s.moves << " swaps=" << s.swaps
+			<< " scratch_bytes=" << s.scratch_bytes << " max_depth=" << s.max_depth;
+	}
+};
+
+template <typename Comp>
+struct instrumented {
+	instrumented(sort_stats& s, const Comp& c = Comp()) : stats(&s), comp(c) { }
+
+	template <typename T>
+	bool operator()(const T& v, const T& w) const { ++stats->compares;  return comp(v, w); }
+
+	sort_stats* stats;
+	Comp comp;
+};
+
+template <typename Comp>
+inline instrumented<Comp> instrument(sort_stats& stats, const Comp& comp) { return instrumented<Comp>(stats, comp); }
+
+// the comparator type an instrumented<Comp> wraps (Comp itself otherwise)
+template <typename Comp>
+struct uninstrumented_type { typedef Comp type; };
+template <typename Comp>
+struct uninstrumented_type<instrumented<Comp>> { typedef Comp type; };
+
+template <typename Comp>
+inline const Comp& uninstrumented(const Comp& comp) { return comp; }
+template <typename Comp>
+inline const Comp& uninstrumented(const instrumented<Comp>& comp) { return comp.comp; }
+
+template <typename Comp>
+inline void count_moves(const Comp&, size_t) { }
+template <typename Comp>
+inline void count_moves(const instrumented<Comp>& comp, size_t moves) { comp.stats->moves += moves; }
+
+template <typename Comp>
+inline void count_swaps(const Comp&, size_t) { }
+template <typename Comp>
+inline void count_swaps(const instrumented<Comp>& comp, size_t swaps) {
+	comp.stats->swaps += swaps;
+	comp.stats->moves += 3 * swaps;
 }
-//  std::cout << "in less..., v is: " << v << ", w is: " << w << "\n";
-//  bool comparison = comp(v, w);
-//  return comparison;
-//}
+
+template <typename Comp>
+inline void count_scratch(const Comp&, size_t) { }
+template <typename Comp>
+inline void count_scratch(const instrumented<Comp>& comp, size_t bytes) { comp.stats->scratch_bytes += bytes; }
+
+// declared at the top of a recursive call: tracks the nesting while it is in scope
+template <typename Comp>
+struct recursion_depth {
+	explicit recursion_depth(const Comp&) { }
+};
+
+template <typename Comp>
+struct recursion_depth<instrumented<Comp>> {
+	explicit recursion_depth(const instrumented<Comp>& comp) : stats(comp.stats) {
+		if (++stats->depth > stats->max_depth) { stats->max_depth = stats->depth; }
+	}
+	~recursion_depth() { --stats->depth; }
+	sort_stats* stats;
+};
+
+template <typename T>
+inline bool less(const T& v, const T& w) { return v < w; }
+
+template <typename T, typename Comp>
+inline bool less(const T& v, const T& w, const Comp& comp) { return comp(v, w); }
 
 
 template <typename T>
-inline bool compare(T& v, T& w) {
+inline int compare(const T& v, const T& w) {
 	int result;
 
 	if (less(v, w)) {
@@ -180,8 +288,8 @@ inline bool compare(T& v, T& w) {
 	return result;
 }
 
-template <typename T>
-inline int compare(T& v, T& w, const comparator<T>& comp) {
+template <typename T, typename Comp>
+inline int compare(const T& v, const T& w, const Comp& comp) {
 	int result;
 
 	if (less(v, w, comp)) {
@@ -198,12 +306,20 @@ inline int compare(T& v, T& w, const comparator<T>& comp) {
 
 template <typename T>
 void exchange(T* a, size_t i, size_t j) {
-	T swap = a[i];
-	a[i] = a[j];
-	a[j] = swap;
+	T swap = std::move(a[i]);
+	a[i] = std::move(a[j]);
+	a[j] = std::move(swap);
 }
 
+// exchange() for sorts that carry a comparator: counted when it is instrumented
+template <typename T, typename Comp>
+inline void exchange(T* a, size_t i, size_t j, const Comp& comp) {
+	count_swaps(comp, 1);
+	exchange(a, i, j);
+}
 
+
+// checks a[low..high) -- high is exclusive
 template <typename T>
 bool is_sorted(T* a, size_t low, size_t high) {
 	for (size_t i = low + 1; i < high; ++i) {
@@ -212,21 +328,21 @@ bool is_sorted(T* a, size_t low, size_t high) {
 	return true;
 }
 
-template <typename T>
-bool is_sorted(T* a, size_t low, size_t high, const comparator<T>& comp) {
+template <typename T, typename Comp>
+bool is_sorted(T* a, size_t low, size_t high, const Comp& comp) {
 	for (size_t i = low + 1; i < high; ++i) {
-		if (less(a[i], a[i - 1], comp)) { return false; }
+		if (less(a[i], a[i - 1], uninstrumented(comp))) { return false; }
 	}
 	return true;
 }
 
 
 template <typename T>
-bool is_sorted(T* a, size_t size) { return is_sorted(a, 0, size - 1); }
+bool is_sorted(T* a, size_t size) { return is_sorted(a, 0, size); }
 
-template <typename T>
-bool is_sorted(T* a, size_t size, const comparator<T>& comp) {
-	return is_sorted(a, 0, size - 1, comp);
+template <typename T, typename Comp, if_comparator<Comp, T> = 0>
+bool is_sorted(T* a, size_t size, const Comp& comp) {
+	return is_sorted(a, 0, size, comp);
 }
 
 #endif
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <fstream>
 #include <iomanip>
 #include <string>
+#include <vector>
 
 #include "Slist.h"
 #include "Stack.h"
@@ -185,9 +186,9 @@ void test_selection_sort(const std::string& msg, T* arr, size_t n) {
 	//std::cout << "\n";
 }
 
-template <typename T, typename S>
+template <typename T, typename Comp, typename S>
 void test_sort(const std::string& msg, T* arr, size_t n,
-	const comparator<T>& comp, const S& sort) {
+	const Comp& comp, const S& sort) {
 	sort.sort(arr, n, comp);
 	print(msg, arr, n);
 	std::cout << "\n";
@@ -218,7 +219,7 @@ void test_sort(const std::string& msg, T* arr, size_t n,
 //  single_issorted_test(test_str2, 2, std::size(test_str2));
 //
 //  std::cout << "\nsorting unsorted arrays now with selection_sort.........\n";
-//  comparator<int> comp_int;
+//  fwd_comparator<int> comp_int;
 //  selection_sort<int> sel_sort;
 //  test_sort("test1 is now: ", test1, std::size(test1), comp_int, sel_sort);
 //  test_sort("test2 is now: ", test2, std::size(test2), comp_int, sel_sort);
@@ -234,25 +235,20 @@ void test_sort(const std::string& msg, T* arr, size_t n,
 //  std::cout << "..........................................ending test_sorted()\n\n";
 //}
 
-template <typename T, typename S>
-void test_sort_from_file(const std::string& msg, const comparator<T>& comp, const S& sort) {
-	const size_t BUFFER_SIZE = 1000;
-	std::string words[BUFFER_SIZE];
-	std::fill(words, words + BUFFER_SIZE, "");
-	size_t n = 0;
+template <typename Comp, typename S>
+void test_sort_from_file(const std::string& msg, const Comp& comp, const S& sort) {
+	std::vector<std::string> words;      // grows with the input (inputs larger than memory: External_Sort.h)
 
 	std::string s = "";
 	while (std::cin >> s) {
-		if (s != " ") { words[n++] = s; }
+		if (s != " ") { words.push_back(s); }
 	}
 	for (const std::string& word : words) {
-		if (word != "") {
-			std::cout << word << " ";
-		}
+		std::cout << word << " ";
 	}
 	//  insertion_sort<std::string> ins_sort;
 	//  rev_comparator<std::string> rev_str;
-	test_sort("\n\nAfter " + msg + " sorting, words is now: \n\n", words, n, comp, sort);
+	test_sort("\n\nAfter " + msg + " sorting, words is now: \n\n", words.data(), words.size(), comp, sort);
 
 	std::cout << "\n\n";
 }
@@ -260,9 +256,9 @@ void test_sort_from_file(const std::string& msg, const comparator<T>& comp, cons
 void test_elementary_sorts() {
 	//  test_sorting_utilities();
 
-  //  test_sort_from_file("selection", comparator<std::string>(), selection_sort<std::string>());
-  //  test_sort_from_file("insertion", comparator<std::string>(), insertion_sort<std::string>());
-  //  test_sort_from_file("shell_sort", comparator<std::string>(), shell_sort<std::string>());
+  //  test_sort_from_file("selection", fwd_comparator<std::string>(), selection_sort<std::string>());
+  //  test_sort_from_file("insertion", fwd_comparator<std::string>(), insertion_sort<std::string>());
+  //  test_sort_from_file("shell_sort", fwd_comparator<std::string>(), shell_sort<std::string>());
 
   //  freopen("shellsort.txt", "r", stdin);
 }
@@ -273,7 +269,7 @@ void test_shuffle() {
 	//  int buf[TINY];
 	//  std::fill(buf, buf + TINY, 0);
 	//  std_random<int>::generate_uniform_int(buf, TINY, low, high);
-	//  test_sort("random buffer: ", buf, TINY, comparator<int>(), shell_sort<int>());
+	//  test_sort("random buffer: ", buf, TINY, fwd_comparator<int>(), shell_sort<int>());
 	//
 	//  for (int i = 0; i < TINY; ++i) {
 	//    buf[i] = i;
@@ -0,0 +1,1350 @@
+//
+//  sort_bench.cpp
+//  Algorithms332
+//
+//  Timing driver for the sort classes.  Build it on its own (it has its own
+//  main) with optimizations and NDEBUG, otherwise the is_sorted asserts
+//  dominate every number it prints.
+//
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Utils.h"
+#include "Random.h"
+
+#include "Selection_Sort.h"
+#include "Insertion_Sort.h"
+#include "Shell_Sort.h"
+#include "Merge_Sort.h"
+#include "Quick_Sort.h"
+#include "Heap_Sort.h"
+#include "Parallel_Sort.h"
+#include "Radix_Sort.h"
+#include "String_Sort.h"
+#include "Sorting_Network.h"
+#include "Sort_By_Key.h"
+#include "Argsort.h"
+#include "Selection.h"
+#include "Sort.h"
+
+
+//==========================================================================
+// timing / input helpers
+//==========================================================================
+class stopwatch {
+	typedef std::chrono::steady_clock clock;
+public:
+	stopwatch() : start_(clock::now()) { }
+	void reset() { start_ = clock::now(); }
+	double elapsed_ns() const {
+		return std::chrono::duration<double, std::nano>(clock::now() - start_).count();
+	}
+private:
+	clock::time_point start_;
+};
+
+// time-stamp counter ticks (close to core cycles at a fixed clock); 0 where unavailable
+inline unsigned long long cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// hardware branch-miss counter for the calling thread; Linux perf events only,
+// available() is false elsewhere or when the kernel refuses (e.g., in containers)
+class branch_miss_counter {
+public:
+#ifdef __linux__
+	branch_miss_counter() {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd_ = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+	~branch_miss_counter() { if (fd_ >= 0) { close(fd_); } }
+
+	bool available() const { return fd_ >= 0; }
+	void start() {
+		if (fd_ < 0) { return; }
+		ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	long long stop() {
+		long long count = -1;
+		if (fd_ < 0) { return count; }
+		ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd_, &count, sizeof(count)) != sizeof(count)) { count = -1; }
+		return count;
+	}
+private:
+	int fd_;
+#else
+	bool available() const { return false; }
+	void start() { }
+	long long stop() { return -1; }
+#endif
+};
+
+template <typename T>
+struct counting_comparator {
+	counting_comparator(size_t& count) : count_(count) { }
+	bool operator()(const T& v, const T& w) const { ++count_;  return v < w; }
+	size_t& count_;
+};
+
+inline std::vector<int> random_ints(size_t n) {
+	std::vector<int> v(n);
+	std_random<int>::generate_uniform_int(v.data(), n, 0, int(n));
+	return v;
+}
+
+inline std::vector<std::string> random_words(size_t n, size_t max_len = 12) {
+	std::vector<int> lens(n), chars(n * max_len);
+	std_random<int>::generate_uniform_int(lens.data(), n, 1, int(max_len));
+	std_random<int>::generate_uniform_int(chars.data(), chars.size(), 'a', 'z');
+
+	std::vector<std::string> v(n);
+	for (size_t i = 0; i < n; ++i) {
+		for (int c = 0; c < lens[i]; ++c) { v[i] += char(chars[i * max_len + c]); }
+	}
+	return v;
+}
+
+// best of `reps` runs, each on a fresh copy of `input`
+template <typename T, typename Sort>
+double time_sort(const std::vector<T>& input, Sort sort, int reps = 5) {
+	double best = 0;
+	for (int r = 0; r < reps; ++r) {
+		std::vector<T> work(input);
+		stopwatch sw;
+		sort(work.data(), work.size());
+		double ns = sw.elapsed_ns();
+		if (r == 0 || ns < best) { best = ns; }
+	}
+	return best;
+}
+
+// 1, 2, 4, ... up to and including the hardware thread count
+inline std::vector<size_t> thread_counts() {
+	std::vector<size_t> counts;
+	size_t max_threads = work_stealing_pool::hardware_threads();
+	for (size_t t = 1; t < max_threads; t *= 2) { counts.push_back(t); }
+	counts.push_back(max_threads);
+	return counts;
+}
+
+
+//==========================================================================
+// comparator dispatch: virtual base vs std::function vs inlined functor
+//==========================================================================
+template <typename T, template <typename> class S>
+void bench_comparator_dispatch(const std::string& type_name, const std::string& sort_name,
+	const std::vector<T>& input) {
+	size_t compares = 0;
+	{
+		std::vector<T> work(input);
+		S<T>::sort(work.data(), work.size(), counting_comparator<T>(compares));
+	}
+
+	virtual_comparator<T, fwd_comparator<T>> virt;
+	const comparator<T>& base = virt;
+	comparator_lambda<T> lambda([](const T& v, const T& w) { return v < w; });
+
+	double t_virtual = time_sort(input, [&](T* a, size_t n) { S<T>::sort(a, n, base); });
+	double t_lambda = time_sort(input, [&](T* a, size_t n) { S<T>::sort(a, n, lambda); });
+	double t_inline = time_sort(input, [](T* a, size_t n) { S<T>::sort(a, n); });
+
+	std::cout << std::setw(12) << type_name << std::setw(12) << sort_name
+		<< std::setw(10) << input.size()
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(14) << t_virtual / compares
+		<< std::setw(14) << t_lambda / compares
+		<< std::setw(14) << t_inline / compares << "\n";
+}
+
+void bench_comparator_dispatch() {
+	std::cout << "\ncomparator dispatch (ns per comparison)...\n";
+	std::cout << std::setw(12) << "type" << std::setw(12) << "sort" << std::setw(10) << "n"
+		<< std::setw(14) << "virtual ns/c" << std::setw(14) << "lambda ns/c"
+		<< std::setw(14) << "inline ns/c" << "\n";
+
+	for (size_t n : { 10000, 1000000 }) {
+		std::vector<int> ints = random_ints(n);
+		bench_comparator_dispatch<int, merge_sort>("int", "merge", ints);
+		bench_comparator_dispatch<int, shell_sort>("int", "shell", ints);
+
+		std::vector<std::string> words = random_words(n);
+		bench_comparator_dispatch<std::string, merge_sort>("std::string", "merge", words);
+		bench_comparator_dispatch<std::string, shell_sort>("std::string", "shell", words);
+	}
+}
+
+
+//==========================================================================
+// quick_sort (shuffle + full recursion) vs intro_sort
+//==========================================================================
+void bench_intro_sort() {
+	std::cout << "\nquick_sort vs intro_sort (ns per element)...\n";
+	std::cout << std::setw(10) << "n" << std::setw(12) << "input"
+		<< std::setw(14) << "quick_sort" << std::setw(14) << "intro_sort" << "\n";
+
+	for (size_t n : { 100000, 4000000 }) {
+		std::vector<int> random = random_ints(n);
+		std::vector<int> sorted(random);
+		std::sort(sorted.begin(), sorted.end());
+
+		for (const std::vector<int>* input : { &random, &sorted }) {
+			double t_quick = time_sort(*input, [](int* a, size_t n) { quick_sort<int>::sort(a, n); }, 3);
+			double t_intro = time_sort(*input, [](int* a, size_t n) { intro_sort<int>::sort(a, n); }, 3);
+			std::cout << std::setw(10) << n << std::setw(12) << (input == &random ? "random" : "sorted")
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(14) << t_quick / n << std::setw(14) << t_intro / n << "\n";
+		}
+	}
+}
+
+
+//==========================================================================
+// parallel_quick_sort scaling, 1..hardware threads, checked against intro_sort
+//==========================================================================
+// a group whose tasks throw must still finish, rethrow from wait(), and be reusable
+void test_task_group() {
+	work_stealing_pool pool(2);
+	std::atomic<size_t> ran(0);
+	task_group g(pool);
+	for (size_t i = 0; i < 100; ++i) {
+		g.run([&ran, i] {
+			++ran;
+			if (i % 10 == 3) { throw std::runtime_error("task " + std::to_string(i) + " failed"); }
+		});
+	}
+	bool caught = false;
+	try { g.wait(); }
+	catch (const std::runtime_error& e) { caught = true;  std::cout << "task_group: caught \"" << e.what() << "\"\n"; }
+	std::cout << "task_group: " << ran << " of 100 tasks ran, " << (caught ? "exception rethrown" : "EXCEPTION LOST") << "\n";
+
+	g.run([&ran] { ++ran; });
+	g.wait();      // the error was consumed: the group is reusable
+	std::cout << "task_group: reused after a failure, " << ran << " of 101 tasks ran\n";
+}
+
+void bench_parallel_quick_sort(size_t n = 10000000) {
+	test_task_group();
+	std::cout << "\nparallel_quick_sort scaling, n = " << n << "...\n";
+	std::vector<int> input = random_ints(n);
+	std::vector<int> expected(input);
+	double t_seq = time_sort(input, [](int* a, size_t n) { intro_sort<int>::sort(a, n); }, 3);
+	intro_sort<int>::sort(expected.data(), n);
+
+	std::cout << std::setw(8) << "threads" << std::setw(14) << "2-way ms" << std::setw(10) << "speedup"
+		<< std::setw(14) << "3-way ms" << std::setw(10) << "speedup" << std::setw(8) << "ok" << "\n";
+	for (size_t threads : thread_counts()) {
+		work_stealing_pool pool(threads);
+		double t2 = time_sort(input, [&](int* a, size_t n) {
+			parallel_quick_sort<int>::sort(a, n, fwd_comparator<int>(), pool); }, 3);
+		double t3 = time_sort(input, [&](int* a, size_t n) {
+			parallel_quick_sort<int>::sort_3way(a, n, fwd_comparator<int>(), pool); }, 3);
+
+		std::vector<int> work2(input), work3(input);
+		parallel_quick_sort<int>::sort(work2.data(), n, fwd_comparator<int>(), pool);
+		parallel_quick_sort<int>::sort_3way(work3.data(), n, fwd_comparator<int>(), pool);
+		bool ok = work2 == expected && work3 == expected;
+
+		std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+			<< std::setw(14) << t2 / 1e6 << std::setw(10) << t_seq / t2
+			<< std::setw(14) << t3 / 1e6 << std::setw(10) << t_seq / t3
+			<< std::setw(8) << yes_or_no(ok) << "\n";
+	}
+}
+
+
+//==========================================================================
+// parallel_merge_sort scaling, checked against merge_sort
+//==========================================================================
+void bench_parallel_merge_sort(size_t n = 10000000) {
+	std::cout << "\nparallel_merge_sort scaling, n = " << n << "...\n";
+	std::vector<int> input = random_ints(n);
+	std::vector<int> expected(input);
+	double t_seq = time_sort(input, [](int* a, size_t n) { merge_sort<int>::sort(a, n); }, 3);
+	merge_sort<int>::sort(expected.data(), n);
+
+	std::cout << std::setw(8) << "threads" << std::setw(14) << "ms" << std::setw(10) << "speedup"
+		<< std::setw(8) << "ok" << "\n";
+	for (size_t threads : thread_counts()) {
+		work_stealing_pool pool(threads);
+		double t = time_sort(input, [&](int* a, size_t n) {
+			parallel_merge_sort<int>::sort(a, n, fwd_comparator<int>(), pool); }, 3);
+
+		std::vector<int> work(input);
+		parallel_merge_sort<int>::sort(work.data(), n, fwd_comparator<int>(), pool);
+
+		std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+			<< std::setw(14) << t / 1e6 << std::setw(10) << t_seq / t
+			<< std::setw(8) << yes_or_no(work == expected) << "\n";
+	}
+}
+
+
+//==========================================================================
+// parallel_sample_sort scaling next to parallel_quick_sort, both against
+// intro_sort on one thread
+//==========================================================================
+void bench_parallel_sample_sort(size_t n = 50000000) {
+	std::cout << "\nparallel_sample_sort scaling, n = " << n << "...\n";
+	std::vector<int> input = random_ints(n);
+	std::vector<int> expected(input);
+	double t_seq = time_sort(input, [](int* a, size_t n) { intro_sort<int>::sort(a, n); }, 3);
+	intro_sort<int>::sort(expected.data(), n);
+
+	std::cout << std::setw(8) << "threads" << std::setw(14) << "sample ms" << std::setw(10) << "speedup"
+		<< std::setw(14) << "quick ms" << std::setw(10) << "speedup" << std::setw(8) << "ok" << "\n";
+	for (size_t threads : thread_counts()) {
+		work_stealing_pool pool(threads);
+		double t_sample = time_sort(input, [&](int* a, size_t n) {
+			parallel_sample_sort<int>::sort(a, n, fwd_comparator<int>(), pool); }, 3);
+		double t_quick = time_sort(input, [&](int* a, size_t n) {
+			parallel_quick_sort<int>::sort(a, n, fwd_comparator<int>(), pool); }, 3);
+
+		std::vector<int> work(input);
+		parallel_sample_sort<int>::sort(work.data(), n, fwd_comparator<int>(), pool);
+
+		std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+			<< std::setw(14) << t_sample / 1e6 << std::setw(10) << t_seq / t_sample
+			<< std::setw(14) << t_quick / 1e6 << std::setw(10) << t_seq / t_quick
+			<< std::setw(8) << yes_or_no(work == expected) << "\n";
+	}
+}
+
+
+//==========================================================================
+// intro_sort with quick_sort::partition vs quick_sort::block_partition
+//==========================================================================
+template <typename T, bool Block>
+void bench_partition_scheme(const std::vector<T>& input, double& ns, long long& misses) {
+	ns = time_sort(input, [](T* a, size_t n) { intro_sort<T, Block>::sort(a, n); }, 3);
+
+	std::vector<T> work(input);
+	branch_miss_counter counter;
+	counter.start();
+	intro_sort<T, Block>::sort(work.data(), work.size());
+	misses = counter.stop();
+}
+
+template <typename T>
+void bench_block_partition(const std::string& type_name, const std::string& input_name,
+	const std::vector<T>& input) {
+	double ns_hoare, ns_block;
+	long long miss_hoare, miss_block;
+	bench_partition_scheme<T, false>(input, ns_hoare, miss_hoare);
+	bench_partition_scheme<T, true>(input, ns_block, miss_block);
+
+	size_t n = input.size();
+	std::cout << std::setw(8) << type_name << std::setw(12) << input_name << std::setw(10) << n
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(12) << ns_hoare / n << std::setw(12) << ns_block / n;
+	if (miss_hoare >= 0) {
+		std::cout << std::setw(14) << double(miss_hoare) / n << std::setw(14) << double(miss_block) / n;
+	}
+	else { std::cout << std::setw(14) << "n/a" << std::setw(14) << "n/a"; }
+	std::cout << "\n";
+}
+
+void bench_block_partition(size_t n = 10000000) {
+	std::cout << "\nintro_sort partition vs block_partition (per element)...\n";
+	std::cout << std::setw(8) << "type" << std::setw(12) << "input" << std::setw(10) << "n"
+		<< std::setw(12) << "hoare ns" << std::setw(12) << "block ns"
+		<< std::setw(14) << "hoare misses" << std::setw(14) << "block misses" << "\n";
+
+	std::vector<int> ints = random_ints(n);
+	std::vector<int> few(n);
+	std_random<int>::generate_uniform_int(few.data(), n, 0, 15);
+	std::vector<double> doubles(ints.begin(), ints.end());
+	for (double& d : doubles) { d = d / 7.0; }
+
+	bench_block_partition<int>("int", "random", ints);
+	bench_block_partition<int>("int", "few-unique", few);
+	bench_block_partition<double>("double", "random", doubles);
+}
+
+
+//==========================================================================
+// pdq_sort vs intro_sort on presorted patterns
+//==========================================================================
+template <template <typename> class S>
+void bench_presorted_row(const std::string& sort_name, const std::string& input_name,
+	const std::vector<int>& input) {
+	size_t compares = 0;
+	{
+		std::vector<int> work(input);
+		S<int>::sort(work.data(), work.size(), counting_comparator<int>(compares));
+	}
+	double ns = time_sort(input, [](int* a, size_t n) { S<int>::sort(a, n); }, 3);
+
+	size_t n = input.size();
+	std::cout << std::setw(12) << sort_name << std::setw(18) << input_name << std::setw(10) << n
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(12) << ns / n << std::setw(14) << double(compares) / n << "\n";
+}
+
+void bench_pdq_sort(size_t n = 4000000) {
+	std::cout << "\npdq_sort vs intro_sort on presorted input (per element)...\n";
+	std::cout << std::setw(12) << "sort" << std::setw(18) << "input" << std::setw(10) << "n"
+		<< std::setw(12) << "ns" << std::setw(14) << "compares" << "\n";
+
+	std::vector<int> random = random_ints(n);
+	std::vector<int> sorted(random);
+	std::sort(sorted.begin(), sorted.end());
+	std::vector<int> reversed(sorted.rbegin(), sorted.rend());
+	std::vector<int> appended(sorted);
+	std::copy(random.begin(), random.begin() + n / 1000, appended.end() - n / 1000);
+
+	const std::pair<const char*, const std::vector<int>*> inputs[] = {
+		{ "random", &random }, { "sorted", &sorted }, { "reversed", &reversed },
+		{ "sorted+0.1% tail", &appended },
+	};
+	for (const auto& input : inputs) {
+		bench_presorted_row<intro_sort>("intro_sort", input.first, *input.second);
+		bench_presorted_row<pdq_sort>("pdq_sort", input.first, *input.second);
+	}
+}
+
+
+//==========================================================================
+// merge_bu_sort vs tim_sort on run-structured input
+//==========================================================================
+void bench_tim_sort(size_t n = 4000000) {
+	std::cout << "\nmerge_bu_sort vs tim_sort on run-structured input (per element)...\n";
+	std::cout << std::setw(12) << "sort" << std::setw(18) << "input" << std::setw(10) << "n"
+		<< std::setw(12) << "ns" << std::setw(14) << "compares" << "\n";
+
+	std::vector<int> random = random_ints(n);
+	std::vector<int> sorted(random);
+	std::sort(sorted.begin(), sorted.end());
+
+	std::vector<int> appended_log(random);          // 16 sorted batches, one after the other
+	for (size_t b = 0; b < 16; ++b) {
+		std::sort(appended_log.begin() + n * b / 16, appended_log.begin() + n * (b + 1) / 16);
+	}
+	std::vector<int> nearly(sorted);                // 1% of neighbours swapped
+	for (size_t i = 0; i + 1 < n; i += 100) { std::swap(nearly[i], nearly[i + 1]); }
+
+	const std::pair<const char*, const std::vector<int>*> inputs[] = {
+		{ "random", &random }, { "sorted", &sorted }, { "16 sorted runs", &appended_log },
+		{ "1% swapped", &nearly },
+	};
+	for (const auto& input : inputs) {
+		bench_presorted_row<merge_bu_sort>("merge_bu", input.first, *input.second);
+		bench_presorted_row<tim_sort>("tim_sort", input.first, *input.second);
+	}
+}
+
+
+//==========================================================================
+// repeated sorts: merge_sort (new aux + copy per merge) vs merge_pp_sort
+//==========================================================================
+void bench_merge_pp_sort(size_t n = 10000, size_t rounds = 2000) {
+	std::cout << "\nmerge_sort vs merge_pp_sort, " << rounds << " sorts of n = " << n << "...\n";
+	std::vector<int> ints = random_ints(n);
+	std::vector<std::string> words = random_words(n);
+
+	auto run = [&](auto input, auto sort) {
+		auto work = input;
+		stopwatch sw;
+		for (size_t r = 0; r < rounds; ++r) {
+			std::copy(input.begin(), input.end(), work.begin());
+			sort(work.data(), work.size());
+		}
+		return sw.elapsed_ns() / (double(rounds) * n);
+	};
+	std::cout << std::setw(12) << "type" << std::setw(14) << "merge ns" << std::setw(14) << "merge_pp ns" << "\n"
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(12) << "int"
+		<< std::setw(14) << run(ints, [](int* a, size_t n) { merge_sort<int>::sort(a, n); })
+		<< std::setw(14) << run(ints, [](int* a, size_t n) { merge_pp_sort<int>::sort(a, n); }) << "\n"
+		<< std::setw(12) << "std::string"
+		<< std::setw(14) << run(words, [](std::string* a, size_t n) { merge_sort<std::string>::sort(a, n); })
+		<< std::setw(14) << run(words, [](std::string* a, size_t n) { merge_pp_sort<std::string>::sort(a, n); })
+		<< "\n";
+}
+
+
+//==========================================================================
+// radix_sort vs the comparison sorts on integer keys
+//==========================================================================
+void bench_radix_sort(size_t n = 10000000) {
+	std::cout << "\nradix_sort vs quick_sort / intro_sort, n = " << n << " (ns per element)...\n";
+	std::vector<int> ints = random_ints(n);
+	std::vector<int> small(n);
+	std_random<int>::generate_uniform_int(small.data(), n, 0, 1000);
+	std::vector<long long> wide(n);
+	for (size_t i = 0; i < n; ++i) { wide[i] = (long long)ints[i] * ints[(i + 1) % n] - ints[(i + 2) % n]; }
+
+	std::cout << std::setw(16) << "input" << std::setw(12) << "quick" << std::setw(12) << "intro"
+		<< std::setw(12) << "radix" << "\n" << std::fixed << std::setprecision(2);
+	for (const auto& input : { std::make_pair("int32 uniform", &ints), std::make_pair("int32 0..1000", &small) }) {
+		std::cout << std::setw(16) << input.first
+			<< std::setw(12) << time_sort(*input.second, [](int* a, size_t n) { quick_sort<int>::sort(a, n); }, 3) / n
+			<< std::setw(12) << time_sort(*input.second, [](int* a, size_t n) { intro_sort<int>::sort(a, n); }, 3) / n
+			<< std::setw(12) << time_sort(*input.second, [](int* a, size_t n) { radix_sort<int>::sort(a, n); }, 3) / n
+			<< "\n";
+	}
+	std::cout << std::setw(16) << "int64 uniform"
+		<< std::setw(12) << time_sort(wide, [](long long* a, size_t n) { quick_sort<long long>::sort(a, n); }, 3) / n
+		<< std::setw(12) << time_sort(wide, [](long long* a, size_t n) { intro_sort<long long>::sort(a, n); }, 3) / n
+		<< std::setw(12) << time_sort(wide, [](long long* a, size_t n) { radix_sort<long long>::sort(a, n); }, 3) / n
+		<< "\n";
+}
+
+
+//==========================================================================
+// multikey_quick_sort vs the comparison sorts on std::string: time and
+// string bytes read (a comparison reads 2 * (common prefix + 1) bytes)
+//==========================================================================
+struct byte_counting_comparator {
+	byte_counting_comparator(size_t& bytes) : bytes_(bytes) { }
+	bool operator()(const std::string& v, const std::string& w) const {
+		size_t n = std::min(v.size(), w.size()), i = 0;
+		while (i < n && v[i] == w[i]) { ++i; }
+		bytes_ += 2 * (i + 1);
+		return i == n ? v.size() < w.size() : (unsigned char)v[i] < (unsigned char)w[i];
+	}
+	size_t& bytes_;
+};
+
+void bench_string_sort(size_t n = 1000000) {
+	std::cout << "\nmultikey_quick_sort vs quick_sort_3way / merge_sort on std::string, n = " << n << "...\n";
+	std::vector<std::string> words = random_words(n);
+	std::vector<std::string> urls(words);
+	for (std::string& s : urls) { s = "https://www.example.com/catalog/items/" + s; }
+
+	typedef multikey_quick_sort<std::string> mkqs;
+	std::cout << std::setw(14) << "input" << std::setw(18) << "sort"
+		<< std::setw(14) << "ns/element" << std::setw(16) << "bytes/element" << "\n" << std::fixed << std::setprecision(2);
+	for (const auto& input : { std::make_pair("words", &words), std::make_pair("long prefix", &urls) }) {
+		auto row = [&](const char* sort_name, auto sort) {
+			size_t bytes = 0;
+			std::vector<std::string> work(*input.second);
+			sort(work.data(), work.size(), bytes);
+			double ns = time_sort(*input.second, [&](std::string* a, size_t m) { size_t b = 0;  sort(a, m, b); }, 3);
+			std::cout << std::setw(14) << input.first << std::setw(18) << sort_name
+				<< std::setw(14) << ns / n << std::setw(16) << double(bytes) / n << "\n";
+		};
+		row("quick_sort_3way", [](std::string* a, size_t m, size_t& bytes) {
+			quick_sort_3way<std::string>::sort(a, m, byte_counting_comparator(bytes)); });
+		row("merge_sort", [](std::string* a, size_t m, size_t& bytes) {
+			merge_sort<std::string>::sort(a, m, byte_counting_comparator(bytes)); });
+		row("mkqs bytes", [](std::string* a, size_t m, size_t& bytes) { mkqs::sort_bytes(a, m, bytes); });
+		row("mkqs cached", [](std::string* a, size_t m, size_t& bytes) { mkqs::sort_cached(a, m, bytes); });
+	}
+}
+
+
+//==========================================================================
+// leaf case: insertion_sort vs sorting_network on independent small blocks
+//==========================================================================
+// a and b hold the same values as multisets of bit patterns
+template <typename T>
+bool same_values(const T* a, const T* b, size_t n) {
+	typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type bits_type;
+	static_assert(sizeof(T) == sizeof(bits_type), "same_values compares 32- and 64-bit keys");
+	std::vector<bits_type> x(n), y(n);
+	std::memcpy(x.data(), a, n * sizeof(T));
+	std::memcpy(y.data(), b, n * sizeof(T));
+	std::sort(x.begin(), x.end());
+	std::sort(y.begin(), y.end());
+	return x == y;
+}
+
+// every block size on ties, signed zeros and NaNs: the output must hold
+// exactly the input's values, bit for bit, and be sorted when there is no NaN
+template <typename T>
+void test_sorting_network() {
+	const size_t MAX = sorting_network<T>::MAX;
+	size_t failures = 0;
+	for (size_t n = 1; n <= MAX; ++n) {
+		for (int kind = 0; kind < 3; ++kind) {
+			if (kind == 2 && !std::numeric_limits<T>::has_quiet_NaN) { continue; }
+			std::vector<T> in(n), out(n);
+			for (size_t i = 0; i < n; ++i) {
+				if (kind == 0) { in[i] = i % 2 ? T(0) : -T(0); }
+				else if (kind == 1) { in[i] = T(int(i * 7 % 5) - 2); }
+				else { in[i] = i % 3 ? T(int(i % 4)) : std::numeric_limits<T>::quiet_NaN(); }
+				out[i] = in[i];
+			}
+			sorting_network<T>::sort_unchecked(out.data(), n);
+			if (!same_values(in.data(), out.data(), n) || (kind != 2 && !is_sorted(out.data(), n))) {
+				std::cout << "sorting_network: n = " << n << ", input " << kind << " FAILED\n";
+				++failures;
+			}
+		}
+	}
+	std::cout << "sorting_network: " << failures << " failures\n";
+}
+
+template <typename T>
+void bench_sorting_network(const std::string& type_name, size_t n) {
+	test_sorting_network<T>();
+	std::vector<int> ints = random_ints(n);
+	std::vector<T> input(ints.begin(), ints.end());
+	for (size_t block = 8; block <= sorting_network<T>::MAX; block *= 2) {
+		auto blocks = [&](auto sort) {
+			return time_sort(input, [&](T* a, size_t m) {
+				for (size_t i = 0; i + block <= m; i += block) { sort(a + i, block); }
+			}, 3) / n;
+		};
+		std::cout << std::setw(12) << type_name << std::setw(8) << block
+			<< std::setw(14) << blocks([](T* a, size_t m) { insertion_sort<T>::sort(a, m); })
+			<< std::setw(14) << blocks([](T* a, size_t m) { sorting_network<T>::sort(a, m); }) << "\n";
+	}
+}
+
+void bench_sorting_network(size_t n = 1 << 20) {
+	std::cout << "\ninsertion_sort vs sorting_network on blocks, n = " << n << " (ns per element)...\n"
+		<< std::setw(12) << "type" << std::setw(8) << "block" << std::setw(14) << "insertion"
+		<< std::setw(14) << "network" << "\n" << std::fixed << std::setprecision(2);
+	bench_sorting_network<int>("int32", n);
+	bench_sorting_network<float>("float", n);
+	bench_sorting_network<long long>("int64", n);
+}
+
+
+//==========================================================================
+// merge kernel throughput: merge_sort's if/else chain vs simd_merge
+//==========================================================================
+template <typename T>
+void branchy_merge(const T* aux, T* arr, size_t low, size_t mid, size_t high) {
+	size_t i = low, j = mid + 1;
+	for (size_t k = low; k <= high; k++) {
+		if (i > mid) { arr[k] = aux[j++]; }
+		else if (j > high) { arr[k] = aux[i++]; }
+		else if (less(aux[j], aux[i])) { arr[k] = aux[j++]; }
+		else { arr[k] = aux[i++]; }
+	}
+}
+
+// merges of runs with ties and signed zeros (and NaNs, for float) at every
+// alignment to the 8-element blocks: the output must hold exactly the
+// inputs' values, bit for bit, and be sorted when there is no NaN
+template <typename T>
+void test_simd_merge() {
+	const size_t WIDTH = simd_merge<T>::WIDTH;
+	size_t failures = 0;
+	for (size_t m = WIDTH; m <= 4 * WIDTH; ++m) {
+		for (size_t n = WIDTH; n <= 4 * WIDTH; ++n) {
+			for (int kind = 0; kind < 3; ++kind) {
+				if (kind == 2 && !std::numeric_limits<T>::has_quiet_NaN) { continue; }
+				std::vector<T> in(m + n), out(m + n);
+				for (size_t i = 0; i < m + n; ++i) {
+					size_t k = i < m ? i : i - m;
+					if (kind == 0) { in[i] = k < (i < m ? m : n) / 2 ? -T(0) : T(0); }
+					else if (kind == 1) { in[i] = T(int(k / 3)); }
+					else { in[i] = k % 5 == 4 ? std::numeric_limits<T>::quiet_NaN() : T(int(k)); }
+				}
+				if (!simd_merge<T>::merge_unchecked(in.data(), m, in.data() + m, n, out.data())) { continue; }
+				if (!same_values(in.data(), out.data(), m + n) || (kind != 2 && !is_sorted(out.data(), m + n))) {
+					std::cout << "simd_merge: m = " << m << ", n = " << n << ", input " << kind << " FAILED\n";
+					++failures;
+				}
+			}
+		}
+	}
+	std::cout << "simd_merge: " << failures << " failures"
+		<< (simd_merge<T>::available() ? "" : " (AVX2 not available)") << "\n";
+}
+
+template <typename T>
+void bench_simd_merge(const std::string& type_name, size_t n, size_t total) {
+	if (n == 1 << 10) { test_simd_merge<T>(); }
+	std::vector<int> ints = random_ints(n);
+	std::vector<T> in(ints.begin(), ints.end()), out(n);
+	std::sort(in.begin(), in.begin() + n / 2);
+	std::sort(in.begin() + n / 2, in.end());
+	const T* a = in.data();
+	const T* b = in.data() + n / 2;
+
+	size_t rounds = total / n;
+	auto per_cycle = [&](auto merge) {
+		unsigned long long start = cycles();
+		for (size_t r = 0; r < rounds; ++r) { merge(); }
+		unsigned long long spent = cycles() - start;
+		return spent == 0 ? 0.0 : double(rounds) * n / double(spent);
+	};
+	std::cout << std::setw(8) << type_name << std::setw(10) << n
+		<< std::setw(12) << per_cycle([&] { branchy_merge(in.data(), out.data(), 0, n / 2 - 1, n - 1); })
+		<< std::setw(12) << per_cycle([&] { simd_merge<T>::merge_scalar(a, b, b, in.data() + n, out.data()); })
+		<< std::setw(12) << per_cycle([&] { simd_merge<T>::merge(a, n / 2, b, n - n / 2, out.data()); })
+		<< "\n";
+}
+
+void bench_simd_merge(size_t total = 100000000) {
+	std::cout << "\nmerge of two sorted halves, elements per cycle (rdtsc), AVX2 "
+		<< (simd_merge<int>::available() ? "available" : "NOT available (simd = scalar fallback)") << "...\n"
+		<< std::setw(8) << "type" << std::setw(10) << "n" << std::setw(12) << "if/else" << std::setw(12) << "ternary"
+		<< std::setw(12) << "simd" << "\n" << std::fixed << std::setprecision(3);
+	for (size_t n : { size_t(1) << 10, size_t(1) << 16, size_t(1) << 22 }) {
+		bench_simd_merge<int>("int32", n, total);
+		bench_simd_merge<float>("float", n, total);
+	}
+	std::cout << std::setprecision(1) << "whole merge_sort<int>, n = 1M (ns per element): "
+		<< time_sort(random_ints(1 << 20), [](int* a, size_t m) { merge_sort<int>::sort(a, m); }, 3) / (1 << 20) << "\n";
+}
+
+
+//==========================================================================
+// sort_by_key vs comparators that derive the key on every comparison, on
+// records shaped like Students.txt ("Last First age gpa")
+//==========================================================================
+struct student_record {
+	std::string last, first;
+	int age;
+	double gpa;
+};
+
+inline std::vector<student_record> random_students(size_t n) {
+	std::vector<std::string> lasts = random_words(n, 10), firsts = random_words(n, 8);
+	std::vector<int> ages(n), gpas(n);
+	std_random<int>::generate_uniform_int(ages.data(), n, 17, 30);
+	std_random<int>::generate_uniform_int(gpas.data(), n, 0, 40);
+
+	std::vector<student_record> v(n);
+	for (size_t i = 0; i < n; ++i) {
+		lasts[i][0] = char(toupper(lasts[i][0]));
+		firsts[i][0] = char(toupper(firsts[i][0]));
+		v[i] = { lasts[i], firsts[i], ages[i], gpas[i] / 10.0 };
+	}
+	return v;
+}
+
+// "Last First" lower-cased with punctuation and spaces stripped
+inline std::string folded_name(const student_record& s) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%s %s", s.last.c_str(), s.first.c_str());
+	strconvert(buf, tolower);
+	strstrip(buf);
+	return buf;
+}
+
+void bench_sort_by_key(size_t n = 200000) {
+	std::cout << "\nsort_by_key vs key-deriving comparators, " << n << " student records (ns per element)...\n";
+	std::vector<student_record> students = random_students(n);
+	typedef student_record S;
+
+	auto name_less = [](const S& a, const S& b) { return folded_name(a) < folded_name(b); };
+	auto gpa_less = [](const S& a, const S& b) { return int(a.gpa * 10 + 0.5) < int(b.gpa * 10 + 0.5); };
+	comparator_lambda<S> name_lambda(name_less), gpa_lambda(gpa_less);
+
+	std::cout << std::setw(12) << "key" << std::setw(22) << "merge_sort(lambda)" << std::setw(18) << "pdq_sort(functor)"
+		<< std::setw(14) << "sort_by_key" << "\n" << std::fixed << std::setprecision(1);
+	std::cout << std::setw(12) << "folded name"
+		<< std::setw(22) << time_sort(students, [&](S* a, size_t m) { merge_sort<S>::sort(a, m, name_lambda); }, 3) / n
+		<< std::setw(18) << time_sort(students, [&](S* a, size_t m) { pdq_sort<S>::sort(a, m, name_less); }, 3) / n
+		<< std::setw(14) << time_sort(students, [](S* a, size_t m) { sort_by_key<S>::sort(a, m, folded_name); }, 3) / n
+		<< "\n";
+	std::cout << std::setw(12) << "gpa * 10"
+		<< std::setw(22) << time_sort(students, [&](S* a, size_t m) { merge_sort<S>::sort(a, m, gpa_lambda); }, 3) / n
+		<< std::setw(18) << time_sort(students, [&](S* a, size_t m) { pdq_sort<S>::sort(a, m, gpa_less); }, 3) / n
+		<< std::setw(14) << time_sort(students, [](S* a, size_t m) {
+			sort_by_key<S>::sort(a, m, [](const S& s) { return int(s.gpa * 10 + 0.5); }); }, 3) / n
+		<< "\n";
+}
+
+
+//==========================================================================
+// moving student records vs argsort (+ apply_permutation) on their indices
+//==========================================================================
+void bench_argsort(size_t n = 500000) {
+	std::cout << "\nrecords vs argsort, " << n << " student records by last name (ns per element)...\n";
+	std::vector<student_record> students = random_students(n);
+	typedef student_record S;
+	auto by_last = [](const S& a, const S& b) { return a.last < b.last; };
+
+	std::cout << std::setw(8) << "sort" << std::setw(12) << "records" << std::setw(12) << "argsort"
+		<< std::setw(18) << "argsort+apply" << "\n" << std::fixed << std::setprecision(1);
+	auto row = [&](const char* name, auto sort_records, auto sort_indices) {
+		std::cout << std::setw(8) << name
+			<< std::setw(12) << time_sort(students, sort_records, 3) / n
+			<< std::setw(12) << time_sort(students, [&](S* a, size_t m) { sort_indices(a, m); }, 3) / n
+			<< std::setw(18) << time_sort(students, [&](S* a, size_t m) {
+				auto perm = sort_indices(a, m);
+				apply_permutation(a, perm.data(), m); }, 3) / n
+			<< "\n";
+	};
+	row("merge", [&](S* a, size_t m) { merge_sort<S>::sort(a, m, by_last); },
+		[&](S* a, size_t m) { return argsort<S>::merge(a, m, by_last); });
+	row("quick", [&](S* a, size_t m) { quick_sort<S>::sort(a, m, by_last); },
+		[&](S* a, size_t m) { return argsort<S>::quick(a, m, by_last); });
+	row("heap", [&](S* a, size_t m) { heap_sort<S>::sort(a, m, by_last); },
+		[&](S* a, size_t m) { return argsort<S>::heap(a, m, by_last); });
+}
+
+
+//==========================================================================
+// heap allocations per sort of long strings: sorts move elements, so the
+// strings themselves should never allocate.  The strings count their own
+// allocations through counting_allocator; the scratch arrays a sort takes
+// are reported separately by count_scratch
+//==========================================================================
+template <typename T>
+struct counting_allocator {
+	typedef T value_type;
+	static size_t allocations;
+
+	counting_allocator() = default;
+	template <typename U>
+	counting_allocator(const counting_allocator<U>&) { }
+
+	T* allocate(size_t n) { ++allocations;  return std::allocator<T>().allocate(n); }
+	void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+	template <typename U>
+	bool operator==(const counting_allocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const counting_allocator<U>&) const { return false; }
+};
+
+template <typename T>
+size_t counting_allocator<T>::allocations = 0;
+
+void bench_allocations(size_t n = 100000) {
+	typedef std::basic_string<char, std::char_traits<char>, counting_allocator<char>> S;
+	std::cout << "\nheap allocations sorting " << n << " strings of 24-40 chars (no small-string buffer)...\n";
+	std::vector<S> words;
+	for (const std::string& w : random_words(n, 16)) { words.emplace_back(("allocation-counting-key/" + w).c_str()); }
+
+	std::cout << std::setw(16) << "sort" << std::setw(8) << "n" << std::setw(14) << "allocations"
+		<< std::setw(16) << "scratch bytes" << std::setw(16) << "ns per element" << "\n"
+		<< std::fixed << std::setprecision(1);
+	auto row = [&](const char* name, size_t m, auto sort) {
+		std::vector<S> work(words.begin(), words.begin() + m);
+		sort_stats stats;
+		size_t before = counting_allocator<char>::allocations;
+		sort(work.data(), m, instrument(stats, fwd_comparator<S>()));
+		size_t count = counting_allocator<char>::allocations - before;
+
+		work.assign(words.begin(), words.begin() + m);
+		stopwatch sw;
+		sort(work.data(), m, fwd_comparator<S>());
+		double ns = sw.elapsed_ns();
+		std::cout << std::setw(16) << name << std::setw(8) << m << std::setw(14) << count
+			<< std::setw(16) << stats.scratch_bytes << std::setw(16) << ns / m << "\n";
+	};
+	size_t small = std::min<size_t>(n, 5000);
+	row("selection", small, [](S* a, size_t m, const auto& comp) { selection_sort<S>::sort(a, m, comp); });
+	row("insertion", small, [](S* a, size_t m, const auto& comp) { insertion_sort<S>::sort(a, m, comp); });
+	row("shell", n, [](S* a, size_t m, const auto& comp) { shell_sort<S>::sort(a, m, comp); });
+	row("merge", n, [](S* a, size_t m, const auto& comp) { merge_sort<S>::sort(a, m, comp); });
+	row("merge_bu", n, [](S* a, size_t m, const auto& comp) { merge_bu_sort<S>::sort(a, m, comp); });
+	row("merge_pp", n, [](S* a, size_t m, const auto& comp) { merge_pp_sort<S>::sort(a, m, comp); });
+	row("tim", n, [](S* a, size_t m, const auto& comp) { tim_sort<S>::sort(a, m, comp); });
+	row("quick", n, [](S* a, size_t m, const auto& comp) { quick_sort<S>::sort(a, m, comp); });
+	row("quick_3way", n, [](S* a, size_t m, const auto& comp) { quick_sort_3way<S>::sort(a, m, comp); });
+	row("intro", n, [](S* a, size_t m, const auto& comp) { intro_sort<S>::sort(a, m, comp); });
+	row("pdq", n, [](S* a, size_t m, const auto& comp) { pdq_sort<S>::sort(a, m, comp); });
+}
+
+
+//==========================================================================
+// heap_sort: bottom-up sifts in binary and 4-ary heaps vs the textbook sink
+//==========================================================================
+// the classic heapsort: sink compares both children, then the sinking element
+template <typename T, typename Comp>
+void top_down_heap_sort(T* a, size_t n, const Comp& comp) {
+	auto sink = [&](size_t k, size_t m) {
+		while (2 * k + 1 < m) {
+			size_t j = 2 * k + 1;
+			if (j + 1 < m && less(a[j], a[j + 1], comp)) { ++j; }
+			if (!less(a[k], a[j], comp)) { break; }
+			exchange(a, k, j);
+			k = j;
+		}
+	};
+	for (size_t k = n / 2; k-- > 0; ) { sink(k, n); }
+	for (size_t m = n - 1; m > 0; --m) {
+		exchange(a, 0, m);
+		sink(0, m);
+	}
+}
+
+template <typename T>
+void heap_sort_row(const char* type, const std::vector<T>& input) {
+	size_t n = input.size();
+	std::cout << std::setw(8) << type << std::setw(10) << n;
+	auto column = [&](auto sort) {
+		size_t compares = 0;
+		std::vector<T> work(input);
+		sort(work.data(), n, counting_comparator<T>(compares));
+		double ns = time_sort(input, [&](T* a, size_t m) { sort(a, m, fwd_comparator<T>()); }, 3);
+		std::cout << std::setw(10) << ns / n << std::setw(8) << double(compares) / n;
+	};
+	column([](T* a, size_t m, auto comp) { top_down_heap_sort(a, m, comp); });
+	column([](T* a, size_t m, auto comp) { heap_sort<T, 2>::sort(a, m, comp); });
+	column([](T* a, size_t m, auto comp) { heap_sort<T, 4>::sort(a, m, comp); });
+	std::cout << "\n";
+}
+
+void bench_heap_sort() {
+	std::cout << "\nheap_sort arities, random input (ns and compares per element)...\n";
+	std::cout << std::setw(18) << " " << std::setw(18) << "top-down 2-ary" << std::setw(18) << "bottom-up 2-ary"
+		<< std::setw(18) << "bottom-up 4-ary" << "\n" << std::fixed << std::setprecision(1);
+	for (size_t n : { size_t(10000), size_t(1000000), size_t(10000000) }) {
+		std::vector<int> v(n);
+		std_random<int>::generate_uniform_int(v.data(), n, 0, int(n));
+		heap_sort_row("int", v);
+	}
+	heap_sort_row("string", random_words(200000));
+}
+
+
+//==========================================================================
+// index_pq arities under a scheduler-like mix: pop the most urgent index and
+// reinsert it with a new deadline, or change the deadline of a random index.
+// The baseline is std::priority_queue with lazy deletion: an update pushes a
+// second entry and pop() skips the stale ones.
+//==========================================================================
+struct pq_workload {
+	std::vector<int> initial, keys, indices, kinds;     // kinds: 0 pop + reinsert, 1 change_key
+};
+
+inline pq_workload make_pq_workload(size_t n, size_t ops) {
+	pq_workload w;
+	w.initial.resize(n);  w.keys.resize(ops);  w.indices.resize(ops);  w.kinds.resize(ops);
+	std_random<int>::generate_uniform_int(w.initial.data(), n, 0, 1 << 30);
+	std_random<int>::generate_uniform_int(w.keys.data(), ops, 0, 1 << 30);
+	std_random<int>::generate_uniform_int(w.indices.data(), ops, 0, int(n - 1));
+	std_random<int>::generate_uniform_int(w.kinds.data(), ops, 0, 1);
+	return w;
+}
+
+template <size_t Arity>
+double time_index_pq(const pq_workload& w, size_t& checksum) {
+	size_t n = w.initial.size();
+	index_min_pq<int, Arity> pq(n);
+	stopwatch sw;
+	pq.heapify(w.initial.data(), n);
+	for (size_t op = 0; op < w.kinds.size(); ++op) {
+		if (w.kinds[op] == 0) {
+			size_t i = pq.pop();
+			checksum += i;
+			pq.insert(i, w.keys[op]);
+		}
+		else { pq.change_key(size_t(w.indices[op]), w.keys[op]); }
+	}
+	return sw.elapsed_ns();
+}
+
+inline double time_lazy_pq(const pq_workload& w, size_t& checksum) {
+	typedef std::pair<int, int> item;                       // (key, index)
+	size_t n = w.initial.size();
+	std::vector<int> current(w.initial);
+	stopwatch sw;
+	std::vector<item> items(n);
+	for (size_t i = 0; i < n; ++i) { items[i] = item(w.initial[i], int(i)); }
+	std::priority_queue<item, std::vector<item>, std::greater<item>> pq(std::greater<item>(), std::move(items));
+	for (size_t op = 0; op < w.kinds.size(); ++op) {
+		if (w.kinds[op] == 0) {
+			while (pq.top().first != current[pq.top().second]) { pq.pop(); }     // stale
+			int i = pq.top().second;
+			pq.pop();
+			checksum += size_t(i);
+			current[i] = w.keys[op];
+			pq.push(item(w.keys[op], i));
+		}
+		else {
+			int i = w.indices[op];
+			current[i] = w.keys[op];
+			pq.push(item(w.keys[op], i));
+		}
+	}
+	return sw.elapsed_ns();
+}
+
+void bench_index_pq(size_t ops = 2000000) {
+	std::cout << "\nindex_pq, " << ops << " ops, half pop + reinsert, half change_key (ns per op)...\n";
+	std::cout << std::setw(10) << "n" << std::setw(10) << "2-ary" << std::setw(10) << "4-ary" << std::setw(10) << "8-ary"
+		<< std::setw(14) << "lazy std::pq" << "\n" << std::fixed << std::setprecision(1);
+	for (size_t n : { size_t(1000), size_t(100000), size_t(4000000) }) {
+		pq_workload w = make_pq_workload(n, ops);
+		size_t sums[4] = { 0, 0, 0, 0 };
+		std::cout << std::setw(10) << n
+			<< std::setw(10) << time_index_pq<2>(w, sums[0]) / ops
+			<< std::setw(10) << time_index_pq<4>(w, sums[1]) / ops
+			<< std::setw(10) << time_index_pq<8>(w, sums[2]) / ops
+			<< std::setw(14) << time_lazy_pq(w, sums[3]) / ops
+			<< (sums[0] == sums[1] && sums[1] == sums[2] ? "" : "   (arities disagree!)") << "\n";
+	}
+}
+
+
+//==========================================================================
+// the median and the top 100 without sorting everything
+//==========================================================================
+void bench_selection(size_t n = 10000000) {
+	std::cout << "\nselection vs sorting, " << n << " random ints (ms, compares per element)...\n";
+	std::vector<int> v(n);
+	std_random<int>::generate_uniform_int(v.data(), n, 0, 1 << 30);
+	std::cout << std::fixed;
+
+	auto row = [&](const char* task, const char* name, auto run) {
+		size_t compares = 0;
+		std::vector<int> work(v);
+		run(work.data(), n, counting_comparator<int>(compares));
+		double ns = time_sort(v, [&](int* a, size_t m) { run(a, m, fwd_comparator<int>()); }, 3);
+		std::cout << std::setw(10) << task << std::setw(22) << name << std::setprecision(1) << std::setw(10) << ns / 1e6
+			<< std::setprecision(2) << std::setw(10) << double(compares) / n << "\n";
+	};
+	size_t mid = n / 2, k = 100;
+	row("median", "intro_sort", [](int* a, size_t m, auto comp) { intro_sort<int>::sort(a, m, comp); });
+	row("median", "std::nth_element", [=](int* a, size_t m, auto comp) { std::nth_element(a, a + mid, a + m, comp); });
+	row("median", "select_kth", [=](int* a, size_t m, auto comp) { quick_select<int>::select_kth(a, m, mid, comp); });
+	row("median", "floyd_rivest", [=](int* a, size_t m, auto comp) { quick_select<int>::floyd_rivest(a, m, mid, comp); });
+	row("top 100", "std::partial_sort", [=](int* a, size_t m, auto comp) { std::partial_sort(a, a + k, a + m, comp); });
+	row("top 100", "partial_sort", [=](int* a, size_t m, auto comp) { quick_select<int>::partial_sort(a, m, k, comp); });
+	row("top 100", "top_k (iterators)", [=](int* a, size_t m, auto comp) {
+		std::vector<int> top = quick_select<int>::top_k(a, a + m, k, comp);
+		a[0] = top[0]; });
+}
+
+
+//==========================================================================
+// the sort suite: every elementary sort x distribution x element type x
+// size, as CSV (default) or JSON, one record per line:
+//   ./sort_bench suite [--json] [--max-n=N]
+// ns_per_element is the best of a few runs on the plain comparator; the
+// operation counts (see sort_stats in Utils.h) come from one more run
+// through instrument(stats, fwd_comparator<T>()), which takes each sort's
+// generic path -- sorting-network leaves, for one, only apply to
+// fwd_comparator itself.
+//==========================================================================
+struct suite_options {
+	bool json = false;
+	size_t max_n = 1000000;
+	size_t max_n_quadratic = 10000;          // selection and insertion sort
+};
+suite_options suite_config;
+
+// uniform doubles in [0, 1) from std_random's ints
+inline std::vector<double> random_unit(size_t n) {
+	std::vector<int> r(n);
+	std_random<int>::generate_uniform_int(r.data(), n, 0, INT_MAX);
+	std::vector<double> u(n);
+	for (size_t i = 0; i < n; ++i) { u[i] = r[i] / (double(INT_MAX) + 1); }
+	return u;
+}
+
+inline std::vector<int> suite_distribution(const std::string& name, size_t n) {
+	std::vector<int> v(n);
+	if (name == "uniform") { std_random<int>::generate_uniform_int(v.data(), n, 0, int(n)); }
+	else if (name == "sorted") { for (size_t i = 0; i < n; ++i) { v[i] = int(i); } }
+	else if (name == "reversed") { for (size_t i = 0; i < n; ++i) { v[i] = int(n - i); } }
+	else if (name == "organ_pipe") { for (size_t i = 0; i < n; ++i) { v[i] = int(i < n / 2 ? i : n - i); } }
+	else if (name == "few_unique") { std_random<int>::generate_uniform_int(v.data(), n, 0, 15); }
+	else if (name == "sawtooth") {             // 16 ascending runs
+		size_t tooth = n / 16 + 1;
+		for (size_t i = 0; i < n; ++i) { v[i] = int(i % tooth); }
+	}
+	else if (name == "zipf") {                 // P(rank k) ~ 1/k over n ranks
+		std::vector<double> cdf(n);
+		double sum = 0;
+		for (size_t k = 0; k < n; ++k) { cdf[k] = sum += 1.0 / double(k + 1); }
+		std::vector<double> u = random_unit(n);
+		for (size_t i = 0; i < n; ++i) {
+			v[i] = int(std::lower_bound(cdf.begin(), cdf.end(), u[i] * sum) - cdf.begin());
+		}
+	}
+	return v;
+}
+
+template <typename T> T suite_key(int k);
+template <> inline int suite_key<int>(int k) { return k; }
+template <> inline double suite_key<double>(int k) { return k + 0.25; }
+template <> inline std::string suite_key<std::string>(int k) {
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%010d", k);      // fixed width: string order == numeric order
+	return buf;
+}
+
+template <typename T> const char* suite_type_name();
+template <> inline const char* suite_type_name<int>() { return "int"; }
+template <> inline const char* suite_type_name<double>() { return "double"; }
+template <> inline const char* suite_type_name<std::string>() { return "string"; }
+
+inline void suite_record(const char* sort, const char* type, const std::string& dist, size_t n,
+	double ns, const sort_stats& s, bool& first) {
+	if (suite_config.json) {
+		std::cout << (first ? "[\n" : ",\n") << "  { \"sort\": \"" << sort << "\", \"type\": \"" << type
+			<< "\", \"distribution\": \"" << dist << "\", \"n\": " << n << ", \"ns_per_element\": " << ns
+			<< ", \"compares\": " << s.compares << ", \"moves\": " << s.moves << ", \"swaps\": " << s.swaps
+			<< ", \"scratch_bytes\": " << s.scratch_bytes << ", \"max_depth\": " << s.max_depth << " }";
+	}
+	else {
+		if (first) { std::cout << "sort,type,distribution,n,ns_per_element,compares,moves,swaps,scratch_bytes,max_depth\n"; }
+		std::cout << sort << "," << type << "," << dist << "," << n << "," << ns << "," << s.compares << ","
+			<< s.moves << "," << s.swaps << "," << s.scratch_bytes << "," << s.max_depth << "\n";
+	}
+	first = false;
+}
+
+template <template <typename> class S, typename T>
+void suite_run(const char* sort, const std::string& dist, const std::vector<int>& keys, bool& first) {
+	size_t n = keys.size();
+	std::vector<T> input(n);
+	for (size_t i = 0; i < n; ++i) { input[i] = suite_key<T>(keys[i]); }
+
+	double ns = time_sort(input, [](T* a, size_t m) { S<T>::sort(a, m); }, n <= 10000 ? 5 : 3);
+	sort_stats stats;
+	std::vector<T> counted(input);
+	S<T>::sort(counted.data(), n, instrument(stats, fwd_comparator<T>()));
+	suite_record(sort, suite_type_name<T>(), dist, n, ns / n, stats, first);
+}
+
+template <typename T>
+void suite_type(bool& first) {
+	const char* dists[] = { "uniform", "sorted", "reversed", "organ_pipe", "few_unique", "zipf", "sawtooth" };
+	for (size_t n = 1000; n <= suite_config.max_n; n *= 10) {
+		for (const char* dist : dists) {
+			std::vector<int> keys = suite_distribution(dist, n);
+			if (n <= suite_config.max_n_quadratic) {
+				suite_run<selection_sort, T>("selection_sort", dist, keys, first);
+				suite_run<insertion_sort, T>("insertion_sort", dist, keys, first);
+			}
+			suite_run<shell_sort, T>("shell_sort", dist, keys, first);
+			suite_run<merge_sort, T>("merge_sort", dist, keys, first);
+			suite_run<merge_bu_sort, T>("merge_bu_sort", dist, keys, first);
+			suite_run<quick_sort, T>("quick_sort", dist, keys, first);
+			suite_run<quick_sort_3way, T>("quick_sort_3way", dist, keys, first);
+			suite_run<intro_sort, T>("intro_sort", dist, keys, first);
+			suite_run<heap_sort, T>("heap_sort", dist, keys, first);
+		}
+	}
+}
+
+void bench_suite() {
+	bool first = true;
+	std::cout << std::fixed << std::setprecision(2);
+	suite_type<int>(first);
+	suite_type<double>(first);
+	suite_type<std::string>(first);
+	if (suite_config.json) { std::cout << "\n]\n"; }
+}
+
+
+//==========================================================================
+// sort() picks an engine per input; pdq_sort and std::sort are the
+// one-engine-for-everything baselines
+//==========================================================================
+template <typename T>
+void bench_adaptive_sort(size_t n) {
+	const char* dists[] = { "uniform", "sorted", "reversed", "organ_pipe", "few_unique", "zipf", "sawtooth" };
+	for (const char* dist : dists) {
+		std::vector<int> keys = suite_distribution(dist, n);
+		std::vector<T> input(n);
+		for (size_t i = 0; i < n; ++i) { input[i] = suite_key<T>(keys[i]); }
+
+		sort_decision decision;
+		std::vector<T> work(input);
+		sort(work.data(), n, fwd_comparator<T>(), [&](const sort_decision& d) { decision = d; });
+
+		double ns_sort = time_sort(input, [](T* a, size_t m) { sort(a, m); }, 3);
+		double ns_pdq = time_sort(input, [](T* a, size_t m) { pdq_sort<T>::sort(a, m); }, 3);
+		double ns_std = time_sort(input, [](T* a, size_t m) { std::sort(a, a + m); }, 3);
+		std::cout << std::setw(8) << suite_type_name<T>() << std::setw(12) << dist << std::setw(22) << decision.engine
+			<< std::setw(10) << ns_sort / n << std::setw(10) << ns_pdq / n << std::setw(10) << ns_std / n << "\n";
+	}
+}
+
+void bench_adaptive_sort(size_t n = 1000000) {
+	std::cout << "\nsort() vs pdq_sort vs std::sort (ns per element, n = " << n << ")...\n";
+	std::cout << std::setw(8) << "type" << std::setw(12) << "input" << std::setw(22) << "engine"
+		<< std::setw(10) << "sort()" << std::setw(10) << "pdq" << std::setw(10) << "std" << "\n";
+	std::cout << std::fixed << std::setprecision(1);
+	bench_adaptive_sort<int>(n);
+	bench_adaptive_sort<double>(n);
+	bench_adaptive_sort<std::string>(n / 4);
+}
+
+
+//==========================================================================
+// shell_sort gap sequences on random ints, up to 10M elements
+//==========================================================================
+template <typename Gaps>
+void bench_shell_gaps(const char* name, const std::vector<int>& input) {
+	size_t n = input.size();
+	double ns = time_sort(input, [](int* a, size_t m) { shell_sort<int, Gaps>::sort(a, m); }, n <= 100000 ? 5 : 2);
+	sort_stats stats;
+	std::vector<int> work(input);
+	shell_sort<int, Gaps>::sort(work.data(), n, instrument(stats, fwd_comparator<int>()));
+	size_t gaps[Gaps::MAX_GAPS];
+	std::cout << std::setw(12) << name << std::setw(10) << n << std::setw(7) << Gaps::gaps(n, gaps)
+		<< std::setw(10) << ns / n << std::setw(12) << double(stats.compares) / n
+		<< std::setw(12) << double(stats.moves) / n << "\n";
+}
+
+void bench_shell_gaps(size_t max_n = 10000000) {
+	std::cout << "\nshell_sort gap sequences on random ints (per element)...\n";
+	std::cout << std::setw(12) << "gaps" << std::setw(10) << "n" << std::setw(7) << "#gaps"
+		<< std::setw(10) << "ns" << std::setw(12) << "compares" << std::setw(12) << "moves" << "\n";
+	std::cout << std::fixed << std::setprecision(1);
+	for (size_t n = 10000; n <= max_n; n *= 10) {
+		std::vector<int> input = random_ints(n);
+		bench_shell_gaps<knuth_gaps>("knuth", input);
+		bench_shell_gaps<ciura_gaps>("ciura", input);
+		bench_shell_gaps<tokuda_gaps>("tokuda", input);
+		bench_shell_gaps<sedgewick_gaps>("sedgewick", input);
+	}
+}
+
+
+//==========================================================================
+// quick_sort_3way: Bentley-McIlroy partition vs the Dijkstra version it
+// replaced, random keys drawn from d distinct values
+//==========================================================================
+// the previous quick_sort_3way: shuffle, then Dijkstra's lt/i/gt partition,
+// which swaps every key that is not equal to the pivot
+template <typename T, typename Comp>
+void dijkstra_quick_sort_3way(T* a, int low, int high, const Comp& comp) {
+	if constexpr (use_sorting_network<T, Comp>::value) {
+		if (high - low < int(sorting_network<T>::MAX)) {
+			if (low < high) { sorting_network<T>::sort(a + low, size_t(high - low + 1)); }
+			return;
+		}
+	}
+	if (high <= low) { return; }
+	int lt = low, i = low + 1, gt = high;
+	T v = a[low];
+	while (i <= gt) {
+		if (less(a[i], v, comp)) { exchange(a, size_t(lt++), size_t(i++), comp); }
+		else if (less(v, a[i], comp)) { exchange(a, size_t(i), size_t(gt--), comp); }
+		else { ++i; }
+	}
+	dijkstra_quick_sort_3way(a, low, lt - 1, comp);
+	dijkstra_quick_sort_3way(a, gt + 1, high, comp);
+}
+
+template <typename T, typename Comp>
+void dijkstra_quick_sort_3way(T* a, size_t n, const Comp& comp) {
+	std_random<T>::shuffle(a, n);
+	count_swaps(comp, n);
+	dijkstra_quick_sort_3way(a, 0, int(n) - 1, comp);
+}
+
+template <typename T>
+void quick_sort_3way_row(const char* type, size_t n, int distinct) {
+	std::vector<int> keys(n);
+	std_random<int>::generate_uniform_int(keys.data(), n, 0, distinct - 1);
+	std::vector<T> input(n);
+	for (size_t i = 0; i < n; ++i) { input[i] = suite_key<T>(keys[i]); }
+
+	std::cout << std::setw(8) << type << std::setw(10) << distinct;
+	auto column = [&](auto sort) {
+		sort_stats stats;
+		std::vector<T> work(input);
+		sort(work.data(), n, instrument(stats, fwd_comparator<T>()));
+		double ns = time_sort(input, [&](T* a, size_t m) { sort(a, m, fwd_comparator<T>()); }, 3);
+		std::cout << std::setw(10) << ns / n << std::setw(10) << double(stats.compares) / n
+			<< std::setw(8) << double(stats.swaps) / n;
+	};
+	column([](T* a, size_t m, auto comp) { dijkstra_quick_sort_3way(a, m, comp); });
+	column([](T* a, size_t m, auto comp) { quick_sort_3way<T>::sort(a, m, comp); });
+	std::cout << "\n";
+}
+
+void bench_quick_sort_3way(size_t n = 1000000) {
+	std::cout << "\nquick_sort_3way partitions by number of distinct keys (per element)...\n";
+	std::cout << std::setw(18) << " " << std::setw(28) << "Dijkstra + shuffle" << std::setw(28) << "Bentley-McIlroy" << "\n"
+		<< std::setw(8) << "type" << std::setw(10) << "distinct"
+		<< std::setw(10) << "ns" << std::setw(10) << "compares" << std::setw(8) << "swaps"
+		<< std::setw(10) << "ns" << std::setw(10) << "compares" << std::setw(8) << "swaps" << "\n";
+	std::cout << std::fixed << std::setprecision(1);
+	for (int distinct : { 2, 10, 100, 1000, 100000, int(n) }) { quick_sort_3way_row<int>("int", n, distinct); }
+	for (int distinct : { 2, 10, 100, 1000, 100000, int(n) }) { quick_sort_3way_row<std::string>("string", n / 5, distinct); }
+}
+
+
+//------------------------------------------------------------------------------
+struct benchmark {
+	const char* name;
+	void (*run)();
+};
+
+const benchmark benchmarks[] = {
+	{ "comparator_dispatch", [] { bench_comparator_dispatch(); } },
+	{ "intro_sort", [] { bench_intro_sort(); } },
+	{ "block_partition", [] { bench_block_partition(); } },
+	{ "pdq_sort", [] { bench_pdq_sort(); } },
+	{ "tim_sort", [] { bench_tim_sort(); } },
+	{ "merge_pp_sort", [] { bench_merge_pp_sort(); } },
+	{ "radix_sort", [] { bench_radix_sort(); } },
+	{ "string_sort", [] { bench_string_sort(); } },
+	{ "sorting_network", [] { bench_sorting_network(); } },
+	{ "simd_merge", [] { bench_simd_merge(); } },
+	{ "sort_by_key", [] { bench_sort_by_key(); } },
+	{ "argsort", [] { bench_argsort(); } },
+	{ "allocations", [] { bench_allocations(); } },
+	{ "heap_sort", [] { bench_heap_sort(); } },
+	{ "index_pq", [] { bench_index_pq(); } },
+	{ "selection", [] { bench_selection(); } },
+	{ "parallel_quick_sort", [] { bench_parallel_quick_sort(); } },
+	{ "parallel_merge_sort", [] { bench_parallel_merge_sort(); } },
+	{ "parallel_sample_sort", [] { bench_parallel_sample_sort(); } },
+	{ "suite", [] { bench_suite(); } },
+	{ "adaptive_sort", [] { bench_adaptive_sort(); } },
+	{ "shell_gaps", [] { bench_shell_gaps(); } },
+	{ "quick_sort_3way", [] { bench_quick_sort_3way(); } },
+};
+
+// Usage: ./sort_bench [--json] [--max-n=N] [benchmark ...]   (no benchmarks runs them all)
+int main(int argc, const char* argv[]) {
+	bool any_selected = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--json") { suite_config.json = true; }
+		else if (arg.compare(0, 8, "--max-n=") == 0) { suite_config.max_n = size_t(atol(arg.c_str() + 8)); }
+		else { any_selected = true; }
+	}
+	for (const benchmark& bench : benchmarks) {
+		bool selected = !any_selected;
+		for (int i = 1; i < argc; ++i) {
+			if (std::string(argv[i]) == bench.name) { selected = true; }
+		}
+		if (selected) { bench.run(); }
+	}
+
+	std::cerr << "\t\t...done.\n";
+	return 0;
+}